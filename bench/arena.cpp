@@ -0,0 +1,38 @@
+//============================================================================
+// @name        : arena.cpp
+// @description : heap allocations and load time with and without the arena
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <optional>
+
+static void arena()
+{
+    const auto data = bench::generate({64, 5000});
+    const auto path = bench::write_temp("arena.ini", data);
+
+    for(const bool use_arena : {false, true})
+    {
+        dot::load_options options;
+        options.arena = use_arena;
+
+        double ns = 0;
+        size_t allocations = 0;
+        for(size_t i = 0; i < 3; i++)
+        {
+            std::optional<dot::settings> settings;
+            const auto before = bench::allocations();
+            const auto elapsed = bench::time([&](){ settings.emplace(path, options); });
+            allocations = bench::allocations() - before;
+            ns = (i == 0) ? elapsed : std::min(ns, elapsed);
+        }
+
+        const std::string name = use_arena ? "load arena" : "load heap";
+        bench::report(name, ns, data.size());
+        std::printf("%-48s %14zu allocations for %zu keys\n", "", allocations, size_t(64 * 5000));
+    }
+}
+
+static bench::registrar registered("arena", arena);
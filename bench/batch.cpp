@@ -0,0 +1,99 @@
+//============================================================================
+// @name        : batch.cpp
+// @description : changing 200 related keys one by one against one commit, and resolving them one by one against find_all
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+static void batch()
+{
+    constexpr size_t count = 200;
+    const auto path = bench::write_temp("batch.ini", bench::generate({10, count}));
+    dot::settings settings(path);
+
+    std::vector<std::pair<dot::key, dot::key>> names;
+    std::vector<std::string> keys;
+    for(size_t i = 0; i < count; i++) keys.push_back(bench::key_name(i));
+    for(const auto& key : keys) names.emplace_back("Section3", key);
+
+    // derived state that depends on all the keys, rebuilt whenever one of them changes
+    size_t rebuilds = 0;
+    const auto rebuild = [&](){ rebuilds++; for(const auto value : settings.find_all(names)) bench::do_not_optimize(value->index()); };
+
+    for(const auto& key : keys) settings["Section3"][key].attach_callback([&](const dot::entry&, void*){ rebuild(); });
+    long round = 0;
+    const auto single_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++, round++)
+        {
+            for(const auto& key : keys) settings["Section3"][key].write_or_change(round);
+        }
+    });
+    bench::report("200 write_or_change, rebuild per key", single_ns);
+    bench::check(rebuilds == static_cast<size_t>(round) * count, "a callback per write");
+
+    for(const auto& key : keys) settings["Section3"][key].attach_callback(nullptr);
+    settings.listen([&](const std::vector<dot::change>&){ rebuild(); });
+    rebuilds = 0;
+    const auto commit_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++, round++)
+        {
+            dot::batch writes;
+            for(const auto& key : keys) writes.write_or_change("Section3", key, round);
+            settings.commit(std::move(writes));
+        }
+    });
+    bench::report("commit of 200 writes, one rebuild", commit_ns);
+    bench::check(rebuilds > 0 and rebuilds <= static_cast<size_t>(round), "one listener call per commit");
+
+    const auto& view = settings;
+    const auto lookup_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            for(const auto& [section, key] : names) bench::do_not_optimize(&view[section][key]);
+        }
+    });
+    bench::report("200 lookups", lookup_ns);
+
+    const auto find_all_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(settings.find_all(names).data());
+    });
+    bench::report("find_all of 200 names", find_all_ns);
+
+    // listeners see the whole batch applied, every entry once, and writes of the same value are skipped
+    dot::settings small;
+    small["a"]["x"].write(1);
+    small["a"]["y"].write(2);
+    size_t entry_calls = 0;
+    small["a"]["x"].attach_callback([&](const dot::entry&, void*){ entry_calls++; bench::check(small["b"]["z"].value() == dot::inivariable(3), "callback before the batch was applied"); });
+    std::vector<dot::change> seen;
+    small.listen([&](const std::vector<dot::change>& changes){ seen = changes; });
+
+    dot::batch writes;
+    writes.write_or_change("a", "x", 5).write_or_change("a", "x", 6).write_or_change("a", "y", 2).write_or_change("b", "z", 3).erase("a", "missing");
+    bench::check(small.commit(std::move(writes)) == 2, "changed entries of a commit");
+    bench::check(entry_calls == 1 and seen.size() == 2 and seen[1].section == "b" and seen[1].key == "z", "coalesced callbacks");
+    bench::check(small["a"]["x"].value() == dot::inivariable(6) and small["a"]["x"].dirty(), "applied in order");
+
+    const auto found = small.find_all({{"a", "x"}, {"a", "nope"}, {"c", "x"}, {"b", "z"}});
+    bench::check(found[0] == &std::as_const(small)["a"]["x"] and found[1] == nullptr and found[2] == nullptr and found[3] != nullptr, "find_all");
+
+    // a lazy value that does not parse fails the commit before anything changed
+    const auto broken = bench::write_temp("batch_broken.ini", "[a]\nx = 1\ny = [1, \"2\"]\n");
+    dot::load_options lazy;
+    lazy.lazy = true;
+    auto lazy_settings = new dot::settings(broken, lazy);
+    dot::batch failing;
+    failing.write_or_change("a", "x", 2).write_or_change("a", "y", 3);
+    bool thrown = false;
+    try { lazy_settings->commit(std::move(failing)); }
+    catch(const std::runtime_error&) { thrown = true; }
+    bench::check(thrown and (*lazy_settings)["a"]["x"].value() == dot::inivariable(1) and not (*lazy_settings)["a"]["x"].dirty(), "failed commit changed something");
+    delete lazy_settings;
+}
+
+static bench::registrar registered("batch", batch);
@@ -0,0 +1,84 @@
+//============================================================================
+// @name        : bench.h
+// @description : tiny benchmark harness and synthetic ini generator
+//============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    struct shape
+    {
+        size_t sections = 10;
+        size_t keys = 100; // per section
+
+        // the kind of every value, cycled over the keys of a section:
+        // i integer, d double, b bool, s string, v list of integers, f list of doubles, t tuple
+        std::string pattern = "idbsvt";
+
+        size_t vector_length = 8;
+        size_t string_length = 0; // strings are padded up to this length
+    };
+
+    [[nodiscard]] std::string generate(const shape& shape);
+
+    // the shape given on the command line
+    [[nodiscard]] shape& custom_shape();
+
+    [[nodiscard]] std::string key_name(size_t index);
+
+    // writes the data to a file in the temp directory and returns its path
+    std::string write_temp(const std::string& name, const std::string& data);
+    [[nodiscard]] std::string read_file(const std::string& path);
+
+    template<typename T>
+    inline void do_not_optimize(const T& value) noexcept
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    // runs fn(iterations) with a growing iteration count until it takes long enough to measure, returns ns per op
+    double measure(const std::function<void(size_t)>& fn);
+
+    // ns taken by a single call to fn
+    template<typename F>
+    double time(F&& fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct child_result
+    {
+        double ns = 0;
+        long peak_rss_kb = 0;
+        bool ok = false;
+    };
+
+    // peak rss is per process, so fn runs and is timed in a forked child that exits without cleaning up
+    child_result run_in_child(const std::function<void()>& fn);
+
+    // the fastest of a few single runs, in ns, for work that cannot be repeated in a tight loop
+    double best_of(size_t runs, const std::function<void()>& fn);
+
+    void report(const std::string& name, double ns_per_op, size_t bytes_per_op = 0);
+
+    // number of calls to the global operator new so far
+    [[nodiscard]] size_t allocations() noexcept;
+
+    // records a failed expectation, the driver exits with a non zero status when any check failed
+    void check(bool condition, const std::string& message);
+
+    struct registrar
+    {
+        registrar(const char* name, std::function<void()> fn);
+    };
+
+    std::vector<std::pair<std::string, std::function<void()>>>& registry();
+}
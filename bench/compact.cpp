@@ -0,0 +1,26 @@
+//============================================================================
+// @name        : compact.cpp
+// @description : per entry memory, sizeof and peak rss of a file with a million keys
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+static void compact()
+{
+    std::printf("sizeof(inivariable)          %zu\n", sizeof(dot::inivariable));
+    std::printf("sizeof(entry)                %zu\n", sizeof(dot::entry));
+    std::printf("sizeof(section::value_type)  %zu\n", sizeof(std::pair<std::pmr::string, dot::entry>));
+
+    const auto data = bench::generate({100, 10000});
+    const auto path = bench::write_temp("compact.ini", data);
+
+    const auto empty = bench::run_in_child([](){});
+    const auto result = bench::run_in_child([&](){ new dot::settings(path); });
+    bench::check(result.ok, "compact child failed");
+
+    bench::report("load 1M keys", result.ns, data.size());
+    std::printf("%-48s %14ld kB peak rss, %ld kB for the file\n", "", result.peak_rss_kb - empty.peak_rss_kb, long(data.size() >> 10));
+}
+
+static bench::registrar registered("compact", compact);
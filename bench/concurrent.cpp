@@ -0,0 +1,134 @@
+//============================================================================
+// @name        : concurrent.cpp
+// @description : read throughput of many threads with a writer, lock free snapshots against a shared mutex
+//============================================================================
+
+#include "bench.h"
+#include "../src/concurrent_settings.h"
+
+#include <atomic>
+#include <chrono>
+#include <shared_mutex>
+#include <thread>
+
+struct result
+{
+    double ns; // per read per thread
+    long writes;
+};
+
+// runs read on every thread for a while, write runs every millisecond on this one
+static result run(size_t threads, const std::function<void(size_t)>& read, const std::function<void(long)>& write)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr auto duration = std::chrono::milliseconds(300);
+
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> total = 0;
+    const auto start = clock::now();
+
+    // readers also watch the clock, a writer that never gets the lock would otherwise keep them going forever
+    std::vector<std::thread> pool;
+    for(size_t t = 0; t < threads; t++)
+    {
+        pool.emplace_back([&, t]()
+        {
+            size_t count = 0;
+            while(not stop.load(std::memory_order_relaxed) and clock::now() - start < duration)
+            {
+                for(size_t i = 0; i < 64; i++) read(count++ + t);
+            }
+            total += count;
+        });
+    }
+
+    long version = 1;
+    for(; clock::now() - start < duration; version++)
+    {
+        write(version);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stop = true;
+    for(auto& thread : pool) thread.join();
+
+    const auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    return {elapsed * static_cast<double>(threads) / static_cast<double>(total.load()), version - 1};
+}
+
+static void report(const std::string& name, size_t threads, const result& result)
+{
+    bench::report(name + " " + std::to_string(threads) + " threads", result.ns);
+    std::printf("%-48s %14ld writes\n", "", result.writes);
+}
+
+static void concurrent()
+{
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+    const bench::shape shape{16, 1000};
+    const auto path = bench::write_temp("concurrent.ini", bench::generate(shape));
+
+    std::vector<std::pair<std::string, std::string>> keys;
+    for(size_t i = 0; i < 1024; i++) keys.emplace_back("Section" + std::to_string(i % shape.sections), bench::key_name(i * 7 % shape.keys));
+
+    const auto write = [](dot::settings& settings, long version)
+    {
+        settings["Section0"]["counter"].write_or_change(version);
+        settings["Section1"]["counter"].write_or_change(version);
+    };
+
+    for(const size_t threads : {1u, 2u, 4u, 8u})
+    {
+        dot::concurrent_settings concurrent(path);
+        report("rcu", threads, run(threads, [&](size_t i)
+        {
+            const auto& [section, key] = keys[i % keys.size()];
+            bench::do_not_optimize(concurrent.read()[section][key].index());
+        },
+        [&](long version){ concurrent.write([&](dot::settings& settings){ write(settings, version); }); }));
+
+        auto locked = dot::settings(path).copy();
+        std::shared_mutex mutex;
+        report("shared_mutex", threads, run(threads, [&](size_t i)
+        {
+            std::shared_lock lock(mutex);
+            const auto& [section, key] = keys[i % keys.size()];
+            bench::do_not_optimize(std::as_const(locked)[section][key].index());
+        },
+        [&](long version)
+        {
+            std::unique_lock lock(mutex);
+            write(locked, version);
+        }));
+    }
+
+    // a reader always sees both counters of one write, never one from before and one from after
+    std::atomic<size_t> torn = 0;
+    dot::concurrent_settings concurrent(path);
+    concurrent.write([&](dot::settings& settings){ write(settings, 0); });
+    run(4, [&](size_t)
+    {
+        const auto snapshot = concurrent.read();
+        if(static_cast<long>(snapshot["Section0"]["counter"].value()) != static_cast<long>(snapshot["Section1"]["counter"].value())) torn++;
+    },
+    [&](long version){ concurrent.write([&](dot::settings& settings){ write(settings, version); }); });
+    bench::check(torn == 0, "a reader saw half of a write");
+
+    // readers of one snapshot convert the same entry at the same time, each new snapshot starts without conversions
+    std::atomic<size_t> wrong = 0;
+    const auto write_list = [](dot::settings& settings, long version){ settings["Section2"]["list"].write_or_change(1.5, 2.5, static_cast<double>(version)); };
+    concurrent.write([&](dot::settings& settings){ write_list(settings, 0); });
+    run(8, [&](size_t i)
+    {
+        const auto snapshot = concurrent.read();
+        const auto& entry = snapshot["Section2"]["list"];
+        const auto& floats = entry.as<std::vector<float>>();
+        const auto& wide = entry.as<std::vector<long double>>();
+        if(floats.size() != 3 or floats[0] != 1.5f or wide.size() != 3 or wide[1] != 2.5l) wrong++;
+        if(i % 2 == 0 and &entry.as<std::vector<float>>() != &floats) wrong++;
+    },
+    [&](long version){ concurrent.write([&](dot::settings& settings){ write_list(settings, version); }); });
+    bench::check(wrong == 0, "concurrent conversions of one entry differ");
+}
+
+static bench::registrar registered("concurrent", concurrent);
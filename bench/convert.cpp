@@ -0,0 +1,65 @@
+//============================================================================
+// @name        : convert.cpp
+// @description : reading a big list of doubles and a tuple by conversion, through a view and through the memoized as
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <numeric>
+
+static void convert()
+{
+    std::string data = "[a]\nlist = [";
+    for(size_t i = 0; i < 10000; i++) data += std::to_string(i) + ".5, ";
+    data += "0.5]\ntuple = (1, 2.5, \"three\", true)\n";
+    const auto path = bench::write_temp("convert.ini", data);
+    dot::settings settings(path);
+    const auto& list = settings["a"]["list"];
+    const auto& tuple = settings["a"]["tuple"];
+
+    using floats = std::vector<float>;
+    using fields = std::tuple<int, double, std::string, bool>;
+
+    const auto sum = [](const auto& values){ return std::accumulate(values.begin(), values.end(), 0.0); };
+
+    bench::report("std::vector<float> conversion", bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(sum(static_cast<floats>(list.value())));
+    }));
+    bench::report("as<std::vector<float>>", bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(sum(list.as<floats>()));
+    }));
+    bench::report("view<double>", bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(sum(list.value().view<double>()));
+    }));
+
+    bench::report("tuple conversion", bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(std::get<2>(static_cast<fields>(tuple.value())).size());
+    }));
+    bench::report("as<tuple>", bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(std::get<2>(tuple.as<fields>()).size());
+    }));
+
+    const auto view = list.value().view<double>();
+    bench::check(view.size() == 10001 and view[3] == 3.5 and view.data() == list.as<std::vector<double>>().data(), "view and stored list are the same");
+    bench::check(list.as<floats>().size() == 10001 and list.as<floats>()[2] == 2.5f and &list.as<floats>() == &list.as<floats>(), "memoized list");
+    bench::check(tuple.as<fields>() == fields{1, 2.5, "three", true}, "memoized tuple");
+
+    settings["a"]["list"].write_or_change(1.0, 2.0);
+    bench::check(list.as<floats>() == floats{1.0f, 2.0f}, "conversion not invalidated by a write");
+
+    dot::batch writes;
+    writes.write_or_change("a", "tuple", 2, 3.5, "four", false);
+    settings.commit(std::move(writes));
+    bench::check(tuple.as<fields>() == fields{2, 3.5, "four", false}, "conversion not invalidated by a commit");
+
+    const auto copy = settings["a"]["list"];
+    bench::check(copy.as<floats>() == floats{1.0f, 2.0f}, "conversion of a copy");
+}
+
+static bench::registrar registered("convert", convert);
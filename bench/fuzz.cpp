@@ -0,0 +1,296 @@
+//============================================================================
+// @name        : fuzz.cpp
+// @description : mutated ini files through every parsing path, which have to agree and round trip. run it in a DOT_SANITIZE build
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+#include "../src/stream_parser.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+
+namespace
+{
+    using values = std::map<std::pair<std::string, std::string>, dot::inivariable>;
+
+    // the values of every non empty entry, the printer leaves out empty sections
+    values collect(const dot::settings& settings)
+    {
+        values result;
+        for(const auto& [name, section] : settings)
+        {
+            for(const auto& [key, entry] : section)
+            {
+                if(entry.has_value()) result.emplace(std::make_pair(std::string(name), std::string(key)), entry.value());
+            }
+        }
+        return result;
+    }
+
+    // values and whether it parsed, with the error
+    struct outcome
+    {
+        bool ok = false;
+        std::string error;
+        values result;
+    };
+
+    template<typename F>
+    outcome run(F&& fn)
+    {
+        outcome result;
+        try
+        {
+            result.result = fn();
+            result.ok = true;
+        }
+        catch(const std::exception& error) { result.error = error.what(); }
+        return result;
+    }
+
+    // tokenizes a heap copy of exactly the right size, so a sanitizer sees every read past the end
+    struct collector final : dot::iniparser::handler
+    {
+        void on_section(std::string_view name, int) override { section = name; }
+        void on_variable(std::string_view key, std::string_view value, int line) override
+        {
+            result.insert_or_assign(std::make_pair(section, std::string(key)), dot::settings::parse_value(value, line).value());
+        }
+
+        std::string section;
+        values result;
+    };
+
+    values tokenize_exact(const std::string& data)
+    {
+        const auto copy = std::make_unique<char[]>(data.size());
+        std::copy(data.begin(), data.end(), copy.get());
+
+        collector collected;
+        dot::iniparser::tokenize(copy.get(), copy.get() + data.size(), collected);
+        return std::move(collected.result);
+    }
+
+    values stream(const std::string& data, size_t chunk)
+    {
+        values result;
+        dot::stream_parser parser(nullptr, [&](std::string_view section, std::string_view key, const dot::entry& value)
+        {
+            result.insert_or_assign(std::make_pair(std::string(section), std::string(key)), value.value());
+        });
+        for(size_t i = 0; i < data.size(); i += chunk) parser.feed(std::string_view(data).substr(i, chunk));
+        parser.finish();
+        return result;
+    }
+
+    // a file in the grammar of test.ini with every kind of value, comments, blank lines and windows line ends
+    std::string seed(std::mt19937_64& random)
+    {
+        const auto pick = [&](size_t count){ return static_cast<size_t>(random() % count); };
+        const auto integer = [&]()
+        {
+            switch(pick(3))
+            {
+                case 0: return std::to_string(static_cast<long>(random() >> (1 + pick(63))) * (pick(2) ? 1 : -1));
+                case 1: return std::string("0x") + "1aF"[pick(3)] + std::to_string(pick(100));
+                default: return std::to_string(pick(10));
+            }
+        };
+        const auto floating = [&]()
+        {
+            switch(pick(3))
+            {
+                case 0: return std::to_string(pick(1000)) + "." + std::to_string(pick(1000));
+                case 1: return std::to_string(pick(10)) + "e" + std::to_string(static_cast<int>(pick(600)) - 300);
+                default: return std::string("-.") + std::to_string(pick(100));
+            }
+        };
+        const auto string = [&]()
+        {
+            const std::string pieces[] = {"text", " ", "\\\"", "#", ";", "=", "[x]", "(1, 2)", "\t", "\xc3\xa9"};
+            std::string result = "\"";
+            for(size_t i = pick(5); i > 0; i--) result += pieces[pick(std::size(pieces))];
+            return result + '"';
+        };
+        const auto scalar = [&](size_t kind) -> std::string
+        {
+            if(kind == 0) return pick(2) ? "true" : "false";
+            if(kind == 1) return string();
+            if(kind == 2) return integer();
+            return floating();
+        };
+        // the elements of a list all have the same kind, a tuple mixes them
+        const auto value = [&]() -> std::string
+        {
+            const auto kind = pick(6);
+            if(kind < 4) return scalar(kind);
+
+            const auto list = kind == 4;
+            const auto element = pick(4);
+            std::string result = list ? "[" : "(";
+            for(size_t i = 0, count = 1 + pick(5); i < count; i++) result += (i == 0 ? "" : pick(2) ? ", " : ",") + scalar(list ? element : pick(4));
+            return result + (list ? "]" : ")");
+        };
+
+        const auto newline = pick(4) == 0 ? "\r\n" : "\n";
+        std::string result;
+        for(size_t s = 0, sections = 1 + pick(4); s < sections; s++)
+        {
+            result += "[Section" + std::to_string(s) + "]" + newline;
+            for(size_t k = 0, keys = pick(8); k < keys; k++)
+            {
+                if(pick(8) == 0) result += std::string(pick(2) ? "# " : "; ") + "comment" + newline;
+                if(pick(8) == 0) result += newline;
+                result += "var" + std::to_string(k) + (pick(2) ? " = " : "=") + value() + newline;
+            }
+            result += newline;
+        }
+        return result;
+    }
+
+    std::string mutate(std::string data, std::mt19937_64& random)
+    {
+        const auto pick = [&](size_t count){ return static_cast<size_t>(random() % count); };
+        constexpr std::string_view special = "[](),\"=#;\n\r\t \\-+.0123456789xeEpP";
+
+        for(size_t i = 1 + pick(4); i > 0 and not data.empty(); i--)
+        {
+            const auto at = pick(data.size());
+            switch(pick(6))
+            {
+                case 0: data[at] = static_cast<char>(random()); break;
+                case 1: data.insert(data.begin() + static_cast<std::ptrdiff_t>(at), special[pick(special.size())]); break;
+                case 2: data.erase(at, 1 + pick(8)); break;
+                case 3: data.resize(at); break;
+                case 4: data.insert(at, data.substr(pick(data.size()), pick(16))); break;
+                default: data[at] = special[pick(special.size())]; break;
+            }
+        }
+        return data;
+    }
+
+    std::string escape(const std::string& data)
+    {
+        std::string result;
+        for(const char c : data)
+        {
+            if(c == '\n') result += "\\n";
+            else if(c == '\r') result += "\\r";
+            else if(c == '"' or c == '\\') result += std::string("\\") + c;
+            else if(static_cast<unsigned char>(c) < 32) result += "\\x" + std::to_string(static_cast<unsigned char>(c));
+            else result += c;
+        }
+        return result;
+    }
+
+    // the paths that parse a whole file have to agree on whether it is valid and on its values
+    bool differential(const std::string& data)
+    {
+        const auto path = bench::write_temp("fuzz.ini", data);
+        // the settings are released without being written back
+        const auto load = [&](dot::load_options options)
+        {
+            return run([&](){ const auto settings = std::make_unique<dot::settings>(dot::settings::load_many({path}, 1, options)); return collect(*settings); });
+        };
+
+        const auto eager = load({});
+        dot::load_options lazy_options;
+        lazy_options.lazy = true;
+        const auto lazy = load(lazy_options);
+        dot::load_options mmap_options;
+        mmap_options.mmap = true;
+        const auto mapped = load(mmap_options);
+
+        const auto exact = run([&](){ return tokenize_exact(data); });
+        const auto streamed = run([&](){ return stream(data, 7); });
+
+        // a lazy load only checks the values that are read, a bad value that a later duplicate key replaced is never read.
+        // the tokenizer and the stream parser do not check for duplicate sections.
+        bool agree = mapped.ok == eager.ok;
+        if(eager.ok) agree = agree and exact.ok and streamed.ok and exact.result == eager.result and streamed.result == eager.result;
+        if(eager.ok) agree = agree and mapped.result == eager.result and lazy.result == eager.result;
+        if(not agree) return false;
+        if(not eager.ok) return true;
+
+        // printed and parsed again gives the same values
+        const auto printed = run([&]()
+        {
+            const auto settings = std::make_unique<dot::settings>(dot::settings::load_many({path}));
+            dot::inibuffer buffer;
+            buffer << *settings;
+            bench::write_temp("fuzz.ini", std::string(buffer.view()));
+            const auto again = std::make_unique<dot::settings>(dot::settings::load_many({path}));
+            return collect(*again);
+        });
+        return printed.ok and printed.result == eager.result;
+    }
+}
+
+static void fuzz()
+{
+    std::mt19937_64 random(42);
+    constexpr size_t seeds = 200;
+    constexpr size_t mutations = 20;
+
+    std::vector<std::string> corpus{bench::read_file("test.ini")};
+    for(size_t i = 0; i < seeds; i++) corpus.push_back(seed(random));
+
+    size_t runs = 0;
+    size_t valid = 0;
+    for(const auto& input : corpus)
+    {
+        for(size_t m = 0; m <= mutations; m++)
+        {
+            const auto data = (m == 0) ? input : mutate(input, random);
+            runs++;
+            if(not differential(data))
+            {
+                bench::check(false, "parsers disagree or the round trip differs on \"" + escape(data) + "\"");
+                bench::write_temp("fuzz_failed.ini", data);
+                return;
+            }
+            valid += run([&](){ return tokenize_exact(data); }).ok;
+        }
+    }
+    std::printf("%zu inputs, %zu valid\n", runs, valid);
+
+    // every seed is valid, which keeps the generator honest
+    const auto invalid = std::find_if(corpus.begin(), corpus.end(), [&](const auto& input){ return not run([&](){ return tokenize_exact(input); }).ok; });
+    bench::check(invalid == corpus.end(), "seed does not parse: \"" + escape(invalid == corpus.end() ? std::string() : *invalid) + "\"");
+
+    // corrupt snapshots throw instead of reading out of bounds
+    const auto snapshot_path = bench::write_temp("fuzz.bin", "");
+    dot::settings::load_many({bench::write_temp("fuzz.ini", corpus[1])}).save_binary(snapshot_path);
+    const auto snapshot = bench::read_file(snapshot_path);
+    for(size_t i = 0; i < 2000; i++)
+    {
+        auto data = snapshot;
+        data[random() % data.size()] = static_cast<char>(random());
+        if(i % 4 == 0) data.resize(random() % data.size());
+        bench::write_temp("fuzz.bin", data);
+        bench::do_not_optimize(run([&](){ return collect(dot::settings::load_binary(snapshot_path)); }).ok);
+    }
+
+    // parse, print and parse again on a big file, which is also the throughput gate
+    const auto data = bench::generate({100, 5000});
+    const auto path = bench::write_temp("fuzz_big.ini", data);
+    const auto parse_ns = bench::best_of(3, [&](){ bench::do_not_optimize(dot::settings::load_many({path}).size()); });
+    bench::report("parse", parse_ns, data.size());
+
+    const auto settings = dot::settings::load_many({path});
+    dot::inibuffer buffer;
+    buffer << settings;
+    const auto printed = bench::write_temp("fuzz_printed.ini", std::string(buffer.view()));
+    bench::check(collect(dot::settings::load_many({printed})) == collect(settings), "big file does not round trip");
+
+#if not defined(__SANITIZE_ADDRESS__) and not defined(__OPTIMIZE_SIZE__)
+    // far below what any machine this runs on does, a drop under it is a regression and not noise
+    const auto megabytes_per_second = static_cast<double>(data.size()) / parse_ns * 1e3;
+    bench::check(megabytes_per_second > 25, "parse throughput below 25 MB/s: " + std::to_string(megabytes_per_second));
+#endif
+}
+
+static bench::registrar registered("fuzz", fuzz);
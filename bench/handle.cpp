@@ -0,0 +1,62 @@
+//============================================================================
+// @name        : handle.cpp
+// @description : reading one value through a string lookup, a precomputed key and a handle
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+static void handle()
+{
+    const auto path = bench::write_temp("handle.ini", bench::generate({100, 1000}));
+    dot::settings settings(path);
+
+    const auto string_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(static_cast<long>(settings["Section42"]["key600"].value()));
+    });
+    bench::report("string lookup", string_ns);
+
+    static constexpr dot::key section = "Section42";
+    static constexpr dot::key key = "key600";
+    const auto key_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(static_cast<long>(settings[section][key].value()));
+    });
+    bench::report("dot::key lookup", key_ns);
+
+    const dot::handle<long> value(settings["Section42"]["key600"]);
+    const auto handle_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(*value);
+    });
+    bench::report("handle", handle_ns);
+
+    // a handle follows changes, also to another type and back, and to values that do not exist yet
+    settings["Section42"]["key600"].change(7);
+    bench::check(*value == 7, "handle does not see a change");
+
+    settings["Section42"]["key600"].change("text");
+    bool thrown = false;
+    try { bench::do_not_optimize(*value); }
+    catch(const std::runtime_error&) { thrown = true; }
+    bench::check(thrown, "handle of the wrong type did not throw");
+
+    settings["Section42"]["key600"].change(8);
+    bench::check(*value == 8, "handle does not see a change back to its type");
+
+    const dot::handle<std::vector<bool>> later(settings["Section42"]["later"]);
+    settings["Section42"]["later"].write(true, false);
+    bench::check(*later == std::vector<bool>{true, false}, "handle does not see a new value");
+
+    const dot::handle<std::string> string(settings["Section0"]["key3"]);
+    bench::check(*string == "value3", "string handle");
+
+    dot::load_options lazy;
+    lazy.lazy = true;
+    dot::settings lazy_settings(path, lazy);
+    const dot::handle<float> number(lazy_settings["Section1"]["key1"]);
+    bench::check(*number == 1.5f, "handle on a lazy value");
+}
+
+static bench::registrar registered("handle", handle);
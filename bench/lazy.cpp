@@ -0,0 +1,86 @@
+//============================================================================
+// @name        : lazy.cpp
+// @description : load time and peak rss of eager and lazy decoding when only a few keys are read
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <sstream>
+
+static std::string print(const dot::entry& entry)
+{
+    std::ostringstream stream;
+    dot::iniprinter::print(stream, entry);
+    return stream.str();
+}
+
+static void load_and_read(const std::string& name, const std::string& path, size_t bytes, const bench::shape& shape, dot::load_options options)
+{
+    // the child exits without destroying the settings, so freeing the tree is not part of the time
+    const auto result = bench::run_in_child([&]()
+    {
+        const auto settings = new dot::settings(path, options);
+        for(size_t i = 0; i < 50; i++)
+        {
+            const auto index = i * 7919;
+            const auto& entry = (*settings)["Section" + std::to_string(index % shape.sections)][bench::key_name(index % shape.keys)];
+            bench::do_not_optimize(entry.value().index());
+        }
+    });
+    bench::check(result.ok, name + " child failed");
+
+    bench::report(name, result.ns, bytes);
+    std::printf("%-48s %14ld kB peak rss\n", "", result.peak_rss_kb);
+}
+
+static void lazy()
+{
+    const bench::shape shape{64, 20000};
+    const auto data = bench::generate(shape);
+    const auto path = bench::write_temp("lazy.ini", data);
+    std::printf("file size: %zu MB, 50 keys read\n", data.size() >> 20);
+
+    dot::load_options lazy;
+    lazy.lazy = true;
+    dot::load_options lazy_mmap = lazy;
+    lazy_mmap.mmap = true;
+
+    load_and_read("eager", path, data.size(), shape, {});
+    load_and_read("lazy", path, data.size(), shape, lazy);
+    load_and_read("lazy mmap", path, data.size(), shape, lazy_mmap);
+
+    // every lazily decoded value is the same as the eager one
+    const auto small = bench::write_temp("lazy_small.ini", bench::generate({4, 600}));
+    const dot::settings eager_settings(small);
+    const dot::settings lazy_settings(small, lazy);
+
+    size_t mismatches = 0;
+    for(const auto& [name, section] : eager_settings)
+    {
+        for(const auto& [key, entry] : section)
+        {
+            const auto& other = lazy_settings[name][key];
+            if(other.undecoded().empty() or other.index() != entry.index() or print(other) != print(entry)) mismatches++;
+        }
+    }
+    bench::check(mismatches == 0, "lazy values differ from eager ones");
+
+    const auto broken = bench::write_temp("lazy_broken.ini", "[a]\nb = [1, 2\nc = [1, \"a\"]\n");
+    const dot::settings broken_settings(broken, lazy);
+    bool thrown = false;
+    try { bench::do_not_optimize(broken_settings["a"]["b"].index()); }
+    catch(const std::runtime_error&) { thrown = true; }
+    bench::check(thrown, "lazy value with a syntax error did not throw on access");
+
+    const auto& mixed = broken_settings["a"]["c"];
+    size_t kind_errors = 0;
+    for(const auto is_kind : {&dot::entry::is_variable, &dot::entry::is_vector, &dot::entry::is_tuple})
+    {
+        try { bench::do_not_optimize((mixed.*is_kind)()); }
+        catch(const std::runtime_error&) { kind_errors++; }
+    }
+    bench::check(kind_errors == 3, "is_variable, is_vector and is_tuple did not throw the syntax error");
+}
+
+static bench::registrar registered("lazy", lazy);
@@ -0,0 +1,34 @@
+//============================================================================
+// @name        : load.cpp
+// @description : load time and peak rss of the copying and the mmap loader
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <optional>
+
+static void load_in_child(const std::string& name, const std::string& path, size_t bytes, dot::load_options options)
+{
+    // the settings is never destroyed, so the file is not written back
+    const auto result = bench::run_in_child([&](){ new dot::settings(path, options); });
+    bench::check(result.ok, name + " child failed");
+
+    bench::report(name, result.ns, bytes);
+    std::printf("%-48s %14ld kB peak rss\n", "", result.peak_rss_kb);
+}
+
+static void load()
+{
+    const auto data = bench::generate({64, 20000});
+    const auto path = bench::write_temp("load.ini", data);
+    std::printf("file size: %zu MB\n", data.size() >> 20);
+
+    dot::load_options mmap;
+    mmap.mmap = true;
+
+    load_in_child("load copy", path, data.size(), {});
+    load_in_child("load mmap", path, data.size(), mmap);
+}
+
+static bench::registrar registered("load", load);
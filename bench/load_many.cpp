@@ -0,0 +1,49 @@
+//============================================================================
+// @name        : load_many.cpp
+// @description : startup with a base file and many overlays, sequential against parallel
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <filesystem>
+#include <thread>
+
+static void load_many()
+{
+    std::vector<std::string> paths;
+    size_t bytes = 0;
+    for(size_t i = 0; i < 64; i++)
+    {
+        const auto data = bench::generate({4, 2000});
+        paths.push_back(bench::write_temp("overlay" + std::to_string(i) + ".ini", data));
+        bytes += data.size();
+    }
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+
+    for(const size_t files : {size_t(1), size_t(4), size_t(16), size_t(64)})
+    {
+        const std::vector<std::string> subset(paths.begin(), paths.begin() + static_cast<std::ptrdiff_t>(files));
+        const auto subset_bytes = bytes / 64 * files;
+
+        for(const unsigned threads : {1u, 0u})
+        {
+            const auto ns = bench::measure([&](size_t iterations)
+            {
+                for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(dot::settings::load_many(subset, threads).size());
+            });
+            bench::report("load_many " + std::to_string(files) + " files " + (threads == 1 ? "sequential" : "parallel"), ns, subset_bytes);
+        }
+    }
+
+    // the options are used for every file, like the cache that is kept next to each of them
+    for(const auto& path : {paths[0], paths[1]}) std::filesystem::remove(path + ".cache");
+    dot::load_options cached;
+    cached.cache = true;
+    cached.arena = true;
+    const auto merged = dot::settings::load_many({paths[0], paths[1]}, 0, cached);
+    const auto both_cached = std::filesystem::exists(paths[0] + ".cache") and std::filesystem::exists(paths[1] + ".cache");
+    bench::check(both_cached and merged.size() == dot::settings(paths[1]).size(), "load_many did not use its options for every file");
+}
+
+static bench::registrar registered("load_many", load_many);
@@ -0,0 +1,77 @@
+//============================================================================
+// @name        : lookup.cpp
+// @description : settings/section lookup cost as the number of keys grows
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <optional>
+
+static void lookup()
+{
+    for(const size_t keys : {size_t(10), size_t(100), size_t(1000), size_t(10000), size_t(100000)})
+    {
+        const auto path = bench::write_temp("lookup.ini", bench::generate({1, keys}));
+        std::optional<dot::settings> settings(std::in_place, path);
+
+        std::vector<std::string> names;
+        for(size_t i = 0; i < keys; i++) names.push_back(bench::key_name((i * 7919) % keys));
+
+        const auto ns = bench::measure([&](size_t iterations)
+        {
+            auto& section = (*settings)["Section0"];
+            for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(section[names[i % keys]].index());
+        });
+        bench::report("section[key] " + std::to_string(keys) + " keys", ns);
+
+        // the previous layout: linear search over a vector of pairs
+        std::vector<std::pair<std::string, size_t>> linear;
+        for(size_t i = 0; i < keys; i++) linear.emplace_back(bench::key_name(i), i);
+
+        const auto linear_ns = bench::measure([&](size_t iterations)
+        {
+            for(size_t i = 0; i < iterations; i++)
+            {
+                const auto& key = names[i % keys];
+                bench::do_not_optimize(std::find_if(linear.begin(), linear.end(), [&key](const auto& elem){ return elem.first == key; }));
+            }
+        });
+        bench::report("linear find_if " + std::to_string(keys) + " keys", linear_ns);
+    }
+}
+
+// a warm lookup by literal, string_view or precomputed key must not touch the heap
+static void lookup_allocations()
+{
+    const auto path = bench::write_temp("lookup_allocations.ini", bench::generate({4, 100}));
+    std::optional<dot::settings> settings(std::in_place, path);
+    const auto& view = *settings;
+
+    static constexpr dot::key section = "Section2";
+    static constexpr dot::key key = "key42";
+    const std::string_view dynamic = "key43";
+
+    constexpr size_t iterations = 100000;
+    const auto before = bench::allocations();
+    for(size_t i = 0; i < iterations; i++)
+    {
+        bench::do_not_optimize(view["Section1"]["key17"].index());
+        bench::do_not_optimize(view[section][key].index());
+        bench::do_not_optimize((*settings)[section][dynamic].index());
+        bench::do_not_optimize(view[section].contains(dynamic));
+    }
+    const auto allocations = bench::allocations() - before;
+
+    std::printf("allocations for %zu warm lookups: %zu\n", 4 * iterations, allocations);
+    bench::check(allocations == 0, "warm lookups allocated");
+
+    const auto ns = bench::measure([&](size_t count)
+    {
+        for(size_t i = 0; i < count; i++) bench::do_not_optimize(view[section][key].index());
+    });
+    bench::report("settings[key][key] precomputed hash", ns);
+}
+
+static bench::registrar registered("lookup", lookup);
+static bench::registrar registered_allocations("lookup allocations", lookup_allocations);
@@ -0,0 +1,276 @@
+//============================================================================
+// @name        : main.cpp
+// @description : benchmark driver, usage: bench [filter]
+//============================================================================
+
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static std::atomic<size_t> allocation_count = 0;
+static bool failed = false;
+
+void* operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if(void* result = std::malloc(size == 0 ? 1 : size)) return result;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// std::pmr::new_delete_resource allocates through the aligned versions
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const auto align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    if(void* result = std::aligned_alloc(align, (size + align - 1) / align * align)) return result;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+// the nothrow versions are used by std::stable_sort among others, they have to free through the same functions
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const auto align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    std::free(pointer);
+}
+
+size_t bench::allocations() noexcept
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+void bench::check(bool condition, const std::string& message)
+{
+    if(condition) return;
+    std::printf("FAILED: %s\n", message.c_str());
+    failed = true;
+}
+
+std::string bench::key_name(size_t index)
+{
+    return "key" + std::to_string(index);
+}
+
+std::string bench::generate(const shape& shape)
+{
+    std::string result;
+    for(size_t s = 0; s < shape.sections; s++)
+    {
+        result += "[Section" + std::to_string(s) + "]\n";
+        for(size_t k = 0; k < shape.keys; k++)
+        {
+            const auto number = std::to_string(k);
+            result += key_name(k) + " = ";
+            switch(shape.pattern[k % shape.pattern.size()])
+            {
+                case 'i': result += number; break;
+                case 'd': result += number + ".5"; break;
+                case 'b': result += (k % 12 == 2) ? "true" : "false"; break;
+                case 's':
+                {
+                    const auto text = "value" + number;
+                    result += '"' + text + std::string(std::max(text.size(), shape.string_length) - text.size(), 'x') + '"';
+                    break;
+                }
+                case 'v':
+                case 'f':
+                {
+                    const auto suffix = (shape.pattern[k % shape.pattern.size()] == 'f') ? ".25" : "";
+                    result += "[" + number + suffix;
+                    for(size_t i = 1; i < shape.vector_length; i++) result += ", " + std::to_string(i) + suffix;
+                    result += "]";
+                    break;
+                }
+                case 't': result += "(true, \"name" + number + "\", " + number + ")"; break;
+                default: throw std::runtime_error("unknown value kind in pattern: " + shape.pattern);
+            }
+            result += '\n';
+        }
+        result += '\n';
+    }
+    return result;
+}
+
+std::string bench::write_temp(const std::string& name, const std::string& data)
+{
+    const auto path = (std::filesystem::temp_directory_path() / ("dot_bench_" + name)).string();
+    std::ofstream(path, std::ios::binary) << data;
+    return path;
+}
+
+std::string bench::read_file(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+double bench::measure(const std::function<void(size_t)>& fn)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr auto minimum = std::chrono::milliseconds(200);
+
+    for(size_t iterations = 1;; iterations *= 2)
+    {
+        const auto start = clock::now();
+        fn(iterations);
+        const auto elapsed = clock::now() - start;
+
+        if(elapsed >= minimum or iterations >= (size_t(1) << 40))
+        {
+            return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+        }
+    }
+}
+
+bench::child_result bench::run_in_child(const std::function<void()>& fn)
+{
+    int fds[2];
+    if(pipe(fds) != 0) return {};
+
+    const auto pid = fork();
+    if(pid == 0)
+    {
+        close(fds[0]);
+        const auto ns = time(fn);
+        [[maybe_unused]] const auto written = write(fds[1], &ns, sizeof(ns));
+        _exit(0);
+    }
+    close(fds[1]);
+
+    child_result result;
+    const auto read_bytes = read(fds[0], &result.ns, sizeof(result.ns));
+    close(fds[0]);
+
+    int status = 0;
+    rusage usage{};
+    wait4(pid, &status, 0, &usage);
+
+    result.peak_rss_kb = usage.ru_maxrss;
+    result.ok = read_bytes == sizeof(result.ns) and WIFEXITED(status);
+    return result;
+}
+
+void bench::report(const std::string& name, double ns_per_op, size_t bytes_per_op)
+{
+    if(bytes_per_op == 0) std::printf("%-48s %14.1f ns/op\n", name.c_str(), ns_per_op);
+    else
+    {
+        const auto mb_per_s = static_cast<double>(bytes_per_op) / ns_per_op * 1e3;
+        std::printf("%-48s %14.1f ns/op %10.1f MB/s\n", name.c_str(), ns_per_op, mb_per_s);
+    }
+}
+
+std::vector<std::pair<std::string, std::function<void()>>>& bench::registry()
+{
+    static std::vector<std::pair<std::string, std::function<void()>>> benches;
+    return benches;
+}
+
+bench::registrar::registrar(const char* name, std::function<void()> fn)
+{
+    registry().emplace_back(name, std::move(fn));
+}
+
+bench::shape& bench::custom_shape()
+{
+    static shape result;
+    return result;
+}
+
+double bench::best_of(size_t runs, const std::function<void()>& fn)
+{
+    double best = 0;
+    for(size_t i = 0; i < runs; i++)
+    {
+        const auto elapsed = time(fn);
+        best = (i == 0) ? elapsed : std::min(best, elapsed);
+    }
+    return best;
+}
+
+// usage: bench [filter] [--sections=N] [--keys=N] [--vector=N] [--string=N] [--pattern=idbsvft]
+int main(int argc, char** argv)
+{
+    std::string filter;
+    auto& shape = bench::custom_shape();
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        const auto equals = arg.find('=');
+        if(arg.rfind("--", 0) != 0 or equals == std::string::npos)
+        {
+            filter = arg;
+            continue;
+        }
+
+        const auto name = arg.substr(2, equals - 2);
+        const auto value = arg.substr(equals + 1);
+        if     (name == "sections") shape.sections = std::stoul(value);
+        else if(name == "keys") shape.keys = std::stoul(value);
+        else if(name == "vector") shape.vector_length = std::stoul(value);
+        else if(name == "string") shape.string_length = std::stoul(value);
+        else if(name == "pattern") shape.pattern = value;
+        else
+        {
+            std::printf("unknown option: %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    for(const auto& [name, fn] : bench::registry())
+    {
+        if(name.find(filter) == std::string::npos) continue;
+        std::printf("--- %s\n", name.c_str());
+        fn();
+    }
+    return failed ? 1 : 0;
+}
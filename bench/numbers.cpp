@@ -0,0 +1,79 @@
+//============================================================================
+// @name        : numbers.cpp
+// @description : number parsing, on a file of mostly numeric vectors and on single values
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <climits>
+
+template<typename T>
+static void expect(const std::string& text, T expected)
+{
+    try
+    {
+        const auto entry = dot::settings::parse_value(text, 1);
+        bench::check(static_cast<T>(entry.value()) == expected and entry.index() == (std::is_same_v<T, double> ? 2u : 3u), "wrong value for " + text);
+    }
+    catch(const std::exception& error)
+    {
+        bench::check(false, "could not parse " + text + ": " + error.what());
+    }
+}
+
+static void expect_error(const std::string& text)
+{
+    try
+    {
+        (void)dot::settings::parse_value(text, 1);
+        bench::check(false, "no error for " + text);
+    }
+    catch(const std::runtime_error&) {}
+}
+
+static void numbers()
+{
+    expect<long>("42", 42);
+    expect<long>("-42", -42);
+    expect<long>("+7", 7);
+    expect<long>("0x1F", 31);
+    expect<long>("-0x10", -16);
+    expect<long>("9223372036854775807", LONG_MAX);
+    expect<long>("-9223372036854775808", LONG_MIN);
+    expect<double>("2.5", 2.5);
+    expect<double>("-.5", -0.5);
+    expect<double>("1e3", 1000.0);
+    expect<double>("-1.5E-2", -0.015);
+    expect<double>("0x1.8p1", 3.0);
+    expect_error("9223372036854775808");
+    expect_error("-9223372036854775809");
+    expect_error("0x10000000000000000");
+    expect_error("1e400");
+    expect_error("--5");
+    expect_error("+-5");
+    expect_error("0x");
+    expect_error("12abc");
+
+    const auto parse = [](const std::string& name, const std::string& list)
+    {
+        const auto ns = bench::measure([&](size_t iterations)
+        {
+            for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(dot::settings::parse_value(list, 1).index());
+        });
+        bench::report(name, ns, list.size());
+    };
+    parse("parse_value 8 integers", "[1, -22, 333, 4444, 123456789, 6, 77, 8]");
+    parse("parse_value 8 doubles", "[1.5, 0.25, 333.125, 4.75, 5.5, 6.0, 123456.789, 0.001]");
+
+    // nine out of ten values are vectors of numbers
+    bench::shape shape{64, 2000, "vfvfvfvfvs", 32};
+    const auto data = bench::generate(shape);
+    const auto path = bench::write_temp("numbers.ini", data);
+
+    const auto result = bench::run_in_child([&](){ new dot::settings(path); });
+    bench::check(result.ok, "numbers child failed");
+    bench::report("load numeric vectors", result.ns, data.size());
+}
+
+static bench::registrar registered("numbers", numbers);
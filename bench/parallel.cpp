@@ -0,0 +1,53 @@
+//============================================================================
+// @name        : parallel.cpp
+// @description : parsing one big file split on section headers, across thread counts
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <optional>
+#include <thread>
+
+static void parallel()
+{
+    const auto data = bench::generate({128, 10000});
+    const auto path = bench::write_temp("parallel.ini", data);
+    std::printf("file size: %zu MB, hardware threads: %u\n", data.size() >> 20, std::thread::hardware_concurrency());
+
+    for(const unsigned threads : {1u, 2u, 4u, 8u, 16u})
+    {
+        dot::load_options options;
+        options.threads = threads;
+
+        // best of three, the write back in the destructor is left out
+        double ns = 0;
+        for(size_t i = 0; i < 3; i++)
+        {
+            std::optional<dot::settings> settings;
+            const auto elapsed = bench::time([&](){ settings.emplace(path, options); });
+            ns = (i == 0) ? elapsed : std::min(ns, elapsed);
+        }
+        bench::report("parse " + std::to_string(threads) + " threads", ns, data.size());
+    }
+
+    // every string hides a line that starts with '[', which is not a place to split at
+    std::string strings;
+    for(size_t i = 0; i < 30000; i++) strings += "[Section" + std::to_string(i) + "]\nk = \"a\n[b]\"\nj = " + std::to_string(i) + "\n";
+    const auto strings_path = bench::write_temp("parallel_strings.ini", strings);
+    dot::load_options split;
+    split.threads = 4;
+    const dot::settings serial(strings_path);
+    const dot::settings parts(strings_path, split);
+
+    bool same = serial.size() == parts.size();
+    for(const auto& [name, section] : serial)
+    {
+        const auto other = parts.find(name);
+        same = same and other != nullptr and other->size() == section.size();
+        for(const auto& [key, entry] : section) same = same and other != nullptr and (*other)[key].value() == entry.value();
+    }
+    bench::check(same, "a split inside a string changed the result");
+}
+
+static bench::registrar registered("parallel", parallel);
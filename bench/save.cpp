@@ -0,0 +1,142 @@
+//============================================================================
+// @name        : save.cpp
+// @description : how long leaving the scope of a changed settings takes with the synchronous save and with the background flusher
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <filesystem>
+
+static void save()
+{
+    const auto text = bench::generate({100, 1000});
+    const auto path = bench::write_temp("save.ini", text);
+
+    dot::load_options async;
+    async.async = true;
+
+    // the time the destructor takes, the write of the async one is awaited by opening the file again
+    const auto shutdown = [&](const dot::load_options& options)
+    {
+        double best = 0;
+        for(int run = 0; run < 5; run++)
+        {
+            auto settings = new dot::settings(path, options);
+            (*settings)["Section3"]["key7"].write_or_change(run);
+            const auto ns = bench::time([&](){ delete settings; });
+            best = (run == 0) ? ns : std::min(best, ns);
+
+            dot::settings written(path, options);
+            bench::check(written["Section3"]["key7"].value() == dot::inivariable(long(run)), "saved on destruction");
+        }
+        return best;
+    };
+    bench::report("destructor, synchronous save", shutdown({}), text.size());
+    bench::report("destructor, async save", shutdown(async), text.size());
+
+    const auto flush_ns = bench::best_of(5, [&]()
+    {
+        dot::settings settings(path, async);
+        settings["Section3"]["key8"].write_or_change(1.5);
+        settings.flush().get();
+    });
+    bench::report("flush, until synced to disk", flush_ns, text.size());
+
+    // a burst of flushes is written once, with every change of the burst
+    const auto small = bench::write_temp("save_small.ini", "[a]\nx = 1\n");
+    {
+        dot::load_options slow = async;
+        slow.debounce = std::chrono::milliseconds(50);
+        dot::settings settings(small, slow);
+        std::vector<std::future<void>> pending;
+        for(long i = 0; i < 100; i++)
+        {
+            settings["a"]["x"].write_or_change(i);
+            settings["a"][bench::key_name(static_cast<size_t>(i))].write_or_change(i);
+            pending.push_back(settings.flush());
+        }
+        pending.back().get();
+        bench::check(std::all_of(pending.begin(), pending.end() - 1, [](auto& future){ return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }), "coalesced flushes resolved together");
+
+        dot::settings written(small);
+        bench::check(written["a"]["x"].value() == dot::inivariable(99l) and written["a"].size() == 101, "coalesced flushes lost a change");
+
+        dot::batch writes;
+        writes.write_or_change("a", "x", 200);
+        settings.commit(std::move(writes));
+        settings.flush().get();
+        bench::check(dot::settings(small)["a"]["x"].value() == dot::inivariable(200l), "commit saved in the background");
+    }
+
+    // every open and reload waits for a pending save, a plain one would read the old value or revert to it
+    {
+        dot::settings reader(small);
+        size_t calls = 0;
+        reader["a"]["x"].attach_callback([&](const dot::entry&, void*){ calls++; });
+
+        dot::load_options slow = async;
+        slow.debounce = std::chrono::milliseconds(50);
+        dot::settings settings(small, slow);
+        settings["a"]["x"].write_or_change(300);
+        auto pending = settings.flush();
+
+        bench::check(dot::settings(small)["a"]["x"].value() == dot::inivariable(300l), "open did not wait for the pending save");
+        const auto first = reader.reload();
+        const auto second = reader.reload();
+        bench::check(first == 1 and second == 0 and calls == 1 and reader["a"]["x"].value() == dot::inivariable(300l), "reload read the file before the pending save");
+        pending.get();
+    }
+
+    // assigning a whole entry is saved like a write, and conversions of the old value are not handed out again
+    const auto assigned = bench::write_temp("save_assigned.ini", "[S]\na = 1\nb = 2\n");
+    {
+        dot::settings settings(assigned);
+        bench::do_not_optimize(settings["S"]["a"].as<int>());
+        settings["S"]["a"] = dot::entry(5l);
+        settings["S"]["b"] = settings["S"]["a"];
+        bench::check(settings["S"]["a"].as<int>() == 5, "assigned entry kept an old conversion");
+    }
+    bench::check(bench::read_file(assigned) == "[S]\na = 5\nb = 5\n", "assigned entries were not saved:\n" + bench::read_file(assigned));
+
+    // errors reach the caller of flush, or on_error when nobody waits
+    const auto directory = std::filesystem::temp_directory_path() / "dot_bench_gone";
+    std::filesystem::create_directories(directory);
+    const auto gone = (directory / "save.ini").string();
+    std::filesystem::copy_file(small, gone, std::filesystem::copy_options::overwrite_existing);
+
+    std::vector<std::string> reported;
+    dot::load_options failing = async;
+    failing.on_error = [&](const std::string& file, std::exception_ptr){ reported.push_back(file); };
+    auto settings = new dot::settings(gone, failing);
+    std::filesystem::remove_all(directory);
+
+    (*settings)["a"]["x"].write_or_change(3);
+    bool thrown = false;
+    try { settings->flush().get(); }
+    catch(const std::runtime_error&) { thrown = true; }
+    bench::check(thrown and reported.empty(), "flush reports its error");
+
+    (*settings)["a"]["x"].write_or_change(4);
+    delete settings;
+    // opening the file waits for its pending write, which fails as the file is gone
+    bool missing = false;
+    try { dot::settings reopened(gone, async); }
+    catch(const std::runtime_error&) { missing = true; }
+    bench::check(missing and reported.size() == 1 and reported[0] == gone, "destructor reports its error");
+
+    failing.async = false;
+    auto synchronous = new dot::settings(small, failing);
+    (*synchronous)["a"]["x"].write_or_change(5);
+    synchronous->flush().get();
+    std::filesystem::create_directories(directory);
+    std::filesystem::copy_file(small, gone);
+    dot::settings moved(gone, failing);
+    std::filesystem::remove_all(directory);
+    moved["a"]["x"].write_or_change(6);
+    *synchronous = std::move(moved);
+    delete synchronous;
+    bench::check(reported.size() == 2, "synchronous save reports its error");
+}
+
+static bench::registrar registered("save", save);
@@ -0,0 +1,100 @@
+//============================================================================
+// @name        : scan.cpp
+// @description : scanning primitives, scalar against the vector versions
+//============================================================================
+
+#include "bench.h"
+#include "../src/scan.h"
+
+#include <random>
+
+using primitive = const char* (*)(const char*, const char*) noexcept;
+
+static std::vector<const dot::scan::scanner*> scanners()
+{
+    std::vector<const dot::scan::scanner*> result{&dot::scan::scalar};
+    if(dot::scan::sse2()) result.push_back(dot::scan::sse2());
+    if(dot::scan::avx2()) result.push_back(dot::scan::avx2());
+    return result;
+}
+
+static const std::pair<const char*, primitive dot::scan::scanner::*> primitives[] =
+{
+    {"find_newline", &dot::scan::scanner::find_newline},
+    {"find_quote", &dot::scan::scanner::find_quote},
+    {"find_not_whitespace", &dot::scan::scanner::find_not_whitespace},
+    {"find_not_alphanumeric", &dot::scan::scanner::find_not_alphanumeric},
+};
+
+// random buffers over an alphabet that hits every character class, every scanner must agree with the scalar one
+static void scan_fuzz()
+{
+    constexpr char alphabet[] = " \t\r\n\"\\aZ09[]=,(#;.\x80\xff";
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(alphabet) - 2);
+    std::uniform_int_distribution<size_t> length(0, 300);
+    std::uniform_int_distribution<int> run(0, 3);
+
+    size_t mismatches = 0;
+    for(size_t round = 0; round < 200000; round++)
+    {
+        // long runs of one class make the vector loops go through several blocks before a match
+        std::string buffer(length(random), ' ');
+        const auto fill = run(random);
+        for(auto& c : buffer)
+        {
+            if(fill == 0) c = alphabet[pick(random)];
+            else if(fill == 1) c = (pick(random) == 0) ? alphabet[pick(random)] : ' ';
+            else if(fill == 2) c = (pick(random) == 0) ? alphabet[pick(random)] : 'a';
+            else c = (pick(random) == 0) ? alphabet[pick(random)] : 'x';
+        }
+
+        const auto offset = buffer.empty() ? 0 : pick(random) % buffer.size();
+        const char* begin = buffer.data() + offset;
+        const char* end = buffer.data() + buffer.size();
+
+        for(const auto& [name, function] : primitives)
+        {
+            const auto expected = (dot::scan::scalar.*function)(begin, end);
+            for(const auto* scanner : scanners())
+            {
+                if((scanner->*function)(begin, end) == expected) continue;
+                if(mismatches++ < 10) std::printf("mismatch in %s %s, length %zu\n", scanner->name, name, buffer.size());
+            }
+        }
+    }
+    std::printf("scanners: %zu, mismatches: %zu\n", scanners().size(), mismatches);
+    bench::check(mismatches == 0, "vector scanners disagree with scalar");
+}
+
+static void scan()
+{
+    for(const size_t run : {size_t(4), size_t(64), size_t(4096)})
+    {
+        // a run of non matching bytes for every primitive, followed by the byte it looks for
+        const std::pair<std::string, char> inputs[] = {{std::string(run, 'a'), '\n'}, {std::string(run, 'a'), '"'}, {std::string(run, ' '), 'a'}, {std::string(run, 'a'), '='}};
+
+        for(size_t i = 0; i < std::size(primitives); i++)
+        {
+            const auto buffer = inputs[i].first + inputs[i].second;
+            const auto function = primitives[i].second;
+
+            for(const auto* scanner : scanners())
+            {
+                const auto ns = bench::measure([&](size_t iterations)
+                {
+                    const char* begin = buffer.data();
+                    for(size_t j = 0; j < iterations; j++)
+                    {
+                        bench::do_not_optimize(begin);
+                        bench::do_not_optimize((scanner->*function)(begin, begin + buffer.size()));
+                    }
+                });
+                bench::report(std::string(primitives[i].first) + " " + scanner->name + " run " + std::to_string(run), ns, buffer.size());
+            }
+        }
+    }
+}
+
+static bench::registrar registered_fuzz("scan fuzz", scan_fuzz);
+static bench::registrar registered("scan", scan);
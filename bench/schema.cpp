@@ -0,0 +1,96 @@
+//============================================================================
+// @name        : schema.cpp
+// @description : filling a struct through a schema against loading a settings and reading every field
+//============================================================================
+
+#include "bench.h"
+#include "../src/schema.h"
+
+namespace
+{
+    struct config
+    {
+        std::string host = "localhost";
+        int port = 0;
+        double timeout = 0;
+        bool verbose = false;
+        std::vector<long> ids;
+        std::vector<std::string> names;
+        float ratio = 0;
+        long missing = -1;
+    };
+
+    constexpr dot::schema config_schema
+    {
+        dot::field{"server", "host", &config::host},
+        dot::field{"server", "port", &config::port},
+        dot::field{"server", "timeout", &config::timeout},
+        dot::field{"server", "verbose", &config::verbose},
+        dot::field{"clients", "ids", &config::ids},
+        dot::field{"clients", "names", &config::names},
+        dot::field{"clients", "ratio", &config::ratio},
+        dot::field{"clients", "missing", &config::missing},
+    };
+
+    const std::string fields = "[server]\nhost = \"example.org\"\nport = 8080\ntimeout = 2.5\nverbose = true\n\n"
+                               "[clients]\nids = [1, 2, 3, 4]\nnames = [\"a\", \"b\"]\nratio = 1\n\n";
+
+    config generic(const std::string& path)
+    {
+        dot::settings settings(path);
+        config result;
+        result.host = static_cast<std::string>(settings["server"]["host"].value());
+        result.port = settings["server"]["port"].value();
+        result.timeout = settings["server"]["timeout"].value();
+        result.verbose = settings["server"]["verbose"].value();
+        result.ids = static_cast<std::vector<long>>(settings["clients"]["ids"].value());
+        result.names = static_cast<const std::vector<std::string>&>(settings["clients"]["names"].value());
+        result.ratio = static_cast<float>(static_cast<long>(settings["clients"]["ratio"].value()));
+        return result;
+    }
+
+    void compare(const std::string& name, const std::string& data)
+    {
+        const auto path = bench::write_temp("schema.ini", data);
+
+        const auto generic_ns = bench::measure([&](size_t iterations)
+        {
+            for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(generic(path).port);
+        });
+        bench::report(name + " settings and value()", generic_ns, data.size());
+
+        const auto schema_ns = bench::measure([&](size_t iterations)
+        {
+            for(size_t i = 0; i < iterations; i++) bench::do_not_optimize(config_schema.load(path).port);
+        });
+        bench::report(name + " schema", schema_ns, data.size());
+    }
+}
+
+static void schema()
+{
+    compare("only fields", fields);
+    compare("fields in 1 MB", fields + bench::generate({10, 1000}));
+
+    const auto result = config_schema.parse(fields);
+    bench::check(result.host == "example.org" and result.port == 8080 and result.timeout == 2.5 and result.verbose, "server fields");
+    bench::check(result.ids == std::vector<long>{1, 2, 3, 4} and result.names == std::vector<std::string>{"a", "b"}, "client fields");
+    bench::check(result.ratio == 1.0f and result.missing == -1, "converted and missing fields");
+
+    std::string message;
+    try { (void)config_schema.parse("[server]\nhost = \"x\"\nport = \"8080\"\n"); }
+    catch(const std::runtime_error& error) { message = error.what(); }
+    bench::check(message == "expected an integer for server.port on line: 3", "type error: " + message);
+
+    message.clear();
+    try { (void)config_schema.parse("[server]\nport = 99999999999\n"); }
+    catch(const std::runtime_error& error) { message = error.what(); }
+    bench::check(message == "integer out of range for server.port on line: 2", "range error: " + message);
+
+    message.clear();
+    try { (void)config_schema.parse("port = 1\n[server]\n"); }
+    catch(const std::runtime_error& error) { message = error.what(); }
+    bench::check(message == "variable has no section on line: 1", "variable before a section: " + message);
+}
+
+static bench::registrar registered("schema", schema);
@@ -0,0 +1,56 @@
+//============================================================================
+// @name        : serialize.cpp
+// @description : printing a whole settings through an ostream and through an inibuffer
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <sstream>
+
+static void serialize()
+{
+    const auto data = bench::generate({64, 20000});
+    const auto path = bench::write_temp("serialize.ini", data);
+    const auto settings = new dot::settings(path);
+
+    size_t bytes = 0;
+    const auto stream_ns = bench::best_of(5, [&]()
+    {
+        std::ostringstream stream;
+        stream << *settings;
+        bytes = stream.str().size();
+    });
+    bench::report("ostringstream", stream_ns, bytes);
+
+    const auto buffer_ns = bench::best_of(5, [&]()
+    {
+        dot::inibuffer buffer;
+        buffer << *settings;
+        bytes = buffer.size();
+    });
+    bench::report("inibuffer", buffer_ns, bytes);
+
+    // the file is written through a buffer, and only when something changed
+    (*settings)["Section0"][bench::key_name(0)].change(1);
+    const auto save_ns = bench::time([&](){ delete settings; });
+    bench::report("save one key changed", save_ns, data.size());
+
+    std::ostringstream stream;
+    dot::inibuffer buffer;
+    const dot::settings small(bench::write_temp("serialize_small.ini", bench::generate({4, 600})));
+    stream << small;
+    buffer << small;
+    bench::check(stream.str() == std::string(buffer.view()), "inibuffer and ostream output differ");
+
+    // doubles come back as the same doubles, never as longs
+    for(const double value : {0.0, -0.0, 2.0, 0.1, 1.0 / 3.0, 123456.789, 1e21, 5e-324, -1.7976931348623157e308, 1e-4})
+    {
+        char text[32];
+        const auto printed = dot::iniprinter::format(value, text);
+        const auto entry = dot::settings::parse_value(printed, 1);
+        bench::check(entry.index() == 2 and static_cast<double>(entry.value()) == value, "double does not round trip: " + std::string(printed));
+    }
+}
+
+static bench::registrar registered("serialize", serialize);
@@ -0,0 +1,92 @@
+//============================================================================
+// @name        : snapshot.cpp
+// @description : startup from text, from a binary snapshot and through the cache, and whether a snapshot reads back the same
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+static bool same(const dot::settings& lhs, const dot::settings& rhs)
+{
+    if(lhs.size() != rhs.size()) return false;
+    for(const auto& [name, section] : lhs)
+    {
+        const auto other = rhs.find(name);
+        if(other == nullptr or other->size() != section.size()) return false;
+        for(const auto& [key, entry] : section)
+        {
+            const auto value = other->find(key);
+            if(value == nullptr or value->value() != entry.value()) return false;
+        }
+    }
+    return true;
+}
+
+static void snapshot()
+{
+    const auto data = bench::generate({100, 5000});
+    const auto path = bench::write_temp("snapshot.ini", data);
+    const auto binary = path + ".bin";
+    const auto cache = path + ".cache";
+    std::remove(cache.c_str());
+    std::printf("file size: %zu MB\n", data.size() >> 20);
+
+    const auto text = dot::settings::load_many({path});
+    text.save_binary(binary);
+    std::printf("snapshot size: %zu MB\n", static_cast<size_t>(std::filesystem::file_size(binary)) >> 20);
+
+    bench::report("parse text", bench::best_of(3, [&](){ dot::settings settings(path); }), data.size());
+    bench::report("load_binary", bench::best_of(3, [&](){ bench::do_not_optimize(dot::settings::load_binary(binary).size()); }), data.size());
+
+    dot::load_options cached;
+    cached.cache = true;
+    bench::report("cache miss, parse and write", bench::time([&](){ dot::settings settings(path, cached); }), data.size());
+    bench::report("cache hit", bench::best_of(3, [&](){ dot::settings settings(path, cached); }), data.size());
+
+    bench::check(same(text, dot::settings::load_binary(binary)), "snapshot does not read back the same");
+    bench::check(same(text, dot::settings(path, cached)), "cache does not read back the same");
+
+    // every kind of value, empty sections and strings that are not plain ascii
+    const auto small = bench::write_temp("snapshot_small.ini",
+        "[a]\nb = true\nd = -2.5\nl = -7\ns = \"h\\xc3\\xa9 \\\"x\\\"\"\nvb = [true, false, true]\nvd = [1.5, 2.0]\n"
+        "vl = [1, 2, 3]\nvs = [\"x\", \"\", \"zz\"]\nt = (1, 2.5, \"three\", false)\n\n[empty]\n\n[last]\nx = 0x10\n");
+    const auto small_text = dot::settings::load_many({small});
+    small_text.save_binary(binary);
+    const auto small_binary = dot::settings::load_binary(binary);
+    bench::check(same(small_text, small_binary), "small snapshot does not read back the same");
+    bench::check(small_binary.contains("empty") and small_binary["last"]["x"].value() == dot::inivariable(16), "small snapshot lost a section");
+
+    // the cache follows the file: the same contents with a new time are a hit, new contents are parsed again
+    dot::settings(small, cached);
+    std::filesystem::last_write_time(small, std::filesystem::last_write_time(small) + std::chrono::seconds(5));
+    bench::check(same(small_text, dot::settings(small, cached)), "cache of a touched file");
+    std::ofstream(small, std::ios::app) << "[new]\ny = 1\n";
+    bench::check(dot::settings(small, cached).contains("new"), "cache was not invalidated by a change");
+
+    const auto load_error = [&](const std::string& contents)
+    {
+        std::ofstream(binary, std::ios::binary) << contents;
+        try { bench::do_not_optimize(dot::settings::load_binary(binary).size()); }
+        catch(const std::runtime_error& error) { return std::string(error.what()); }
+        return std::string();
+    };
+
+    small_text.save_binary(binary);
+    const auto valid = bench::read_file(binary);
+    auto flipped = valid;
+    flipped[flipped.size() / 2] ^= 1;
+    bench::check(load_error(flipped) == "invalid binary snapshot: checksum mismatch", "flipped bit: " + load_error(flipped));
+    bench::check(load_error(valid.substr(0, valid.size() - 1)) == "invalid binary snapshot: truncated file", "truncated snapshot");
+    bench::check(load_error(data.substr(0, 200)) == "invalid binary snapshot: not a snapshot", "text as snapshot");
+
+    // a corrupt cache is parsed again and replaced
+    std::ofstream(small + ".cache", std::ios::binary) << flipped;
+    bench::check(dot::settings(small, cached).contains("new"), "corrupt cache");
+    bench::check(dot::settings::load_binary(small + ".cache").contains("new"), "corrupt cache was not replaced");
+}
+
+static bench::registrar registered("snapshot", snapshot);
@@ -0,0 +1,46 @@
+//============================================================================
+// @name        : stats.cpp
+// @description : what dot::stats reports for a load, and the load time with or without DOT_STATS
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <iostream>
+
+static void stats()
+{
+    const bench::shape shape{100, 5000};
+    const auto data = bench::generate(shape);
+    const auto path = bench::write_temp("stats.ini", data);
+
+    // run once with a DOT_STATS=ON build and once without to see the cost of counting
+    std::printf("built %s DOT_STATS\n", dot::stats::enabled ? "with" : "without");
+    bench::report("load", bench::best_of(3, [&](){ dot::settings settings(path); }), data.size());
+
+    dot::stats::reset();
+    {
+        dot::settings settings(path);
+        bench::do_not_optimize(settings["Section1"]["key1"].value().index());
+        bench::do_not_optimize(settings["Section1"].contains("missing"));
+        bench::do_not_optimize(settings["missing"].empty());
+    }
+    const auto collected = dot::stats::collected();
+    collected.dump(std::cout);
+
+    if constexpr(dot::stats::enabled)
+    {
+        bench::check(collected.files == 1 and collected.bytes == data.size(), "files and bytes");
+        bench::check(collected.sections == shape.sections and collected.variables == shape.sections * shape.keys, "sections and variables");
+        // the pattern idbsvt has one string, one list and one tuple in every 6 keys
+        size_t strings = 0;
+        for(size_t i = 0; i < shape.keys; i++) strings += (i % 6 == 3) ? shape.sections : 0;
+        bench::check(collected.strings == strings and collected.vectors == strings and collected.tuples == strings, "value kinds");
+        // contains does not go through operator[]
+        bench::check(collected.hits == 3 and collected.misses == 1, "lookups");
+        bench::check(collected.read_ns > 0 and collected.tokenize_ns > 0 and collected.decode_ns > 0 and collected.insert_ns > 0, "phases");
+    }
+    else bench::check(collected.files == 0 and collected.hits == 0, "counted without DOT_STATS");
+}
+
+static bench::registrar registered("stats", stats);
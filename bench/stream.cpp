@@ -0,0 +1,59 @@
+//============================================================================
+// @name        : stream.cpp
+// @description : stream_parser fed in chunks against loading the whole file
+//============================================================================
+
+#include "bench.h"
+#include "../src/stream_parser.h"
+
+#include <optional>
+
+static void stream()
+{
+    const auto data = bench::generate({16, 20000});
+    const auto path = bench::write_temp("stream.ini", data);
+
+    size_t expected = 0;
+    {
+        std::optional<dot::settings> settings(std::in_place, path);
+        for(const auto& [name, section] : *settings) expected += section.size();
+    }
+
+    for(const size_t chunk : {size_t(7), size_t(4096), size_t(1) << 16})
+    {
+        size_t variables = 0;
+        size_t buffered = 0;
+
+        const auto ns = bench::measure([&](size_t iterations)
+        {
+            for(size_t i = 0; i < iterations; i++)
+            {
+                variables = 0;
+                dot::stream_parser parser(nullptr, [&variables](std::string_view, std::string_view, const dot::entry&){ variables++; });
+
+                for(size_t offset = 0; offset < data.size(); offset += chunk)
+                {
+                    parser.feed(std::string_view(data).substr(offset, chunk));
+                    buffered = std::max(buffered, parser.buffered());
+                }
+                parser.finish();
+            }
+        });
+        bench::check(variables == expected, "stream parser lost variables");
+        bench::report("stream_parser chunk " + std::to_string(chunk), ns, data.size());
+        std::printf("%-48s %14zu bytes buffered at most\n", "", buffered);
+    }
+
+    std::optional<dot::settings> settings;
+    const auto ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            settings.emplace(path);
+            bench::do_not_optimize(settings->size());
+        }
+    });
+    bench::report("settings from file", ns, data.size());
+}
+
+static bench::registrar registered("stream", stream);
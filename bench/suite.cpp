@@ -0,0 +1,94 @@
+//============================================================================
+// @name        : suite.cpp
+// @description : parse, lookup, value conversion and serialization on files of different shapes
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <optional>
+#include <sstream>
+
+static void run(const std::string& name, const bench::shape& shape)
+{
+    const auto data = bench::generate(shape);
+    const auto path = bench::write_temp("suite.ini", data);
+    std::printf("%s: %zu sections, %zu keys, pattern %s, %.1f MB\n", name.c_str(), shape.sections, shape.keys, shape.pattern.c_str(), static_cast<double>(data.size()) / (1 << 20));
+
+    // destroying the previous settings writes it back, which must stay out of the timing
+    std::optional<dot::settings> settings;
+    double parse_ns = 0;
+    for(size_t i = 0; i < 3; i++)
+    {
+        settings.reset();
+        const auto elapsed = bench::time([&](){ settings.emplace(path); });
+        parse_ns = (i == 0) ? elapsed : std::min(parse_ns, elapsed);
+    }
+    bench::report(name + " parse", parse_ns, data.size());
+
+    std::vector<std::pair<std::string, std::string>> keys;
+    for(size_t i = 0; i < 4096; i++)
+    {
+        const auto index = i * 7919;
+        keys.emplace_back("Section" + std::to_string(index % shape.sections), bench::key_name(index % shape.keys));
+    }
+
+    const auto lookup_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            const auto& [section, key] = keys[i % keys.size()];
+            bench::do_not_optimize((*settings)[section][key].index());
+        }
+    });
+    bench::report(name + " operator[]", lookup_ns);
+
+    // value() into the type every kind converts to
+    const auto& section = (*settings)["Section0"];
+    for(size_t k = 0; k < std::min(shape.pattern.size(), shape.keys); k++)
+    {
+        const auto& entry = section[bench::key_name(k)];
+        const auto kind = shape.pattern[k];
+
+        const auto ns = bench::measure([&](size_t iterations)
+        {
+            for(size_t i = 0; i < iterations; i++)
+            {
+                if     (kind == 'i') bench::do_not_optimize(static_cast<int>(entry.value()));
+                else if(kind == 'd') bench::do_not_optimize(static_cast<float>(entry.value()));
+                else if(kind == 'b') bench::do_not_optimize(static_cast<bool>(entry.value()));
+                else if(kind == 's') bench::do_not_optimize(static_cast<std::string>(entry.value()).size());
+                else if(kind == 'v') bench::do_not_optimize(static_cast<std::vector<int>>(entry.value()).size());
+                else if(kind == 'f') bench::do_not_optimize(static_cast<std::vector<float>>(entry.value()).size());
+                else if(kind == 't') bench::do_not_optimize(std::get<2>(static_cast<std::tuple<bool, std::string, int>>(entry.value())));
+            }
+        });
+        bench::report(name + " value() kind " + kind, ns);
+    }
+
+    size_t bytes = 0;
+    const auto print_ns = bench::best_of(3, [&]()
+    {
+        std::ostringstream stream;
+        stream << *settings;
+        bytes = stream.str().size();
+    });
+    bench::report(name + " operator<<", print_ns, bytes);
+}
+
+static void suite()
+{
+    run("mixed", {64, 5000});
+    run("sections", {20000, 10, "idb"});
+    run("vectors", {16, 1000, "vf", 256});
+    run("tuples", {64, 5000, "t"});
+    run("strings", {64, 2000, "s", 8, 512});
+}
+
+static void custom()
+{
+    run("custom", bench::custom_shape());
+}
+
+static bench::registrar registered("suite", suite);
+static bench::registrar registered_custom("custom", custom);
@@ -0,0 +1,108 @@
+//============================================================================
+// @name        : visit.cpp
+// @description : counting the entries of a file with a visitor against building the settings
+//============================================================================
+
+#include "bench.h"
+#include "../src/visitor.h"
+
+namespace
+{
+    struct counter final : dot::visitor
+    {
+        void on_section(std::string_view, int) override { sections++; }
+        void on_value(std::string_view, std::string_view value, int) override { keys++; bytes += value.size(); }
+
+        size_t sections = 0;
+        size_t keys = 0;
+        size_t bytes = 0;
+    };
+
+    // stops at the first key with the name in the section with the name
+    struct finder final : dot::visitor
+    {
+        finder(std::string_view section_name, std::string_view key_name) : section(section_name), key(key_name) {}
+
+        void on_section(std::string_view name, int) override { inside = (name == section); }
+        bool on_key(std::string_view name, int) override { return inside and name == key; }
+        void on_value(std::string_view, std::string_view value, int line) override { found = value; found_line = line; stop(); }
+
+        std::string_view section;
+        std::string_view key;
+        bool inside = false;
+        std::string_view found;
+        int found_line = 0;
+    };
+}
+
+static void visit()
+{
+    const auto text = bench::generate({100, 1000});
+    const auto path = bench::write_temp("visit.ini", text);
+
+    size_t tree_keys = 0;
+    const auto tree_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            const dot::settings settings(path);
+            tree_keys = 0;
+            for(const auto& [name, section] : settings) tree_keys += section.size();
+        }
+    });
+    bench::report("settings, count keys", tree_ns, text.size());
+
+    counter counted;
+    const auto file_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            counted = counter();
+            dot::visit_file(path, counted);
+        }
+    });
+    bench::report("visit_file, count keys", file_ns, text.size());
+    bench::check(counted.sections == 100 and counted.keys == tree_keys, "visitor and settings disagree");
+
+    const auto before = bench::allocations();
+    const auto memory_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            counter again;
+            dot::visit(text, again);
+            bench::do_not_optimize(again.bytes);
+        }
+    });
+    bench::check(bench::allocations() == before, "visit allocated");
+    bench::report("visit in memory, count keys", memory_ns, text.size());
+
+    const auto find_ns = bench::measure([&](size_t iterations)
+    {
+        for(size_t i = 0; i < iterations; i++)
+        {
+            finder find("Section10", "key5");
+            dot::visit(text, find);
+            bench::do_not_optimize(find.found.data());
+        }
+    });
+    bench::report("visit, stop at Section10.key5", find_ns);
+
+    finder find("Section10", "key5");
+    dot::visit(text, find);
+    const dot::settings settings(path);
+    bench::check(dot::settings::parse_value(find.found, find.found_line).value() == settings["Section10"]["key5"].value(), "found the wrong value");
+
+    // the same syntax errors as settings
+    bool thrown = false;
+    try { counter broken; dot::visit("[a]\nx = 1\n[b\n", broken); }
+    catch(const std::runtime_error& error) { thrown = std::string(error.what()).find("line: 3") != std::string::npos; }
+    bench::check(thrown, "visit did not report the error");
+
+    thrown = false;
+    try { counter orphan; dot::visit("a = 1\n[S]\n", orphan); }
+    catch(const std::runtime_error& error) { thrown = std::string(error.what()) == "variable has no section on line: 1"; }
+    bench::check(thrown, "visit accepted a variable before the first section");
+}
+
+static bench::registrar registered("visit", visit);
@@ -0,0 +1,77 @@
+//============================================================================
+// @name        : watch.cpp
+// @description : time from a file being replaced on disk to the callback of the changed key, and the cost of a reload
+//============================================================================
+
+#include "bench.h"
+#include "../src/watcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+// the way editors save: write a new file next to it and rename it over the old one
+static void replace_file(const std::string& path, const std::string& data)
+{
+    std::ofstream(path + ".edit", std::ios::binary) << data;
+    std::rename((path + ".edit").c_str(), path.c_str());
+}
+
+static void watch()
+{
+    const auto data = bench::generate({64, 20000});
+    const auto path = bench::write_temp("watch.ini", data);
+    std::printf("file size: %zu MB\n", data.size() >> 20);
+
+    dot::settings settings(path);
+    dot::watcher watcher(settings);
+
+    size_t changed_calls = 0;
+    size_t unchanged_calls = 0;
+    settings["Section5"]["key3"].attach_callback([&](const dot::entry&, void*){ changed_calls++; });
+    settings["Section5"]["key4"].attach_callback([&](const dot::entry&, void*){ unchanged_calls++; });
+
+    const auto reload_ns = bench::best_of(3, [&](){ bench::do_not_optimize(settings.reload()); });
+    bench::report("reload without changes", reload_ns, data.size());
+
+    auto edited = data;
+    const auto line = edited.find("key3 = \"value3\"", edited.find("[Section5]"));
+    edited.replace(line, 15, "key3 = \"edited\"");
+
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    replace_file(path, edited);
+
+    size_t changes = 0;
+    for(int i = 0; i < 10 and changes == 0; i++) changes = watcher.poll(std::chrono::milliseconds(1000));
+    const auto latency = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    bench::report("edit to callback", latency, data.size());
+
+    bench::check(changes == 1, "expected one changed entry, got " + std::to_string(changes));
+    bench::check(changed_calls == 1 and unchanged_calls == 0, "callbacks of the wrong entries fired");
+    bench::check(static_cast<std::string>(settings["Section5"]["key3"].value()) == "edited", "edited value not reloaded");
+    bench::check(not settings["Section5"]["key3"].dirty(), "a reloaded entry is written back");
+
+    // a key removed from the file is erased, one with unsaved changes keeps them
+    const auto small = bench::write_temp("watch_small.ini", "[a]\nx = 1\ny = 2\nz = 3\n");
+    dot::settings small_settings(small);
+    dot::watcher small_watcher(small_settings);
+    small_settings["a"]["z"].change(30);
+    replace_file(small, "[a]\nx = 1\nz = 4\n");
+    for(int i = 0; i < 10 and small_watcher.poll(std::chrono::milliseconds(1000)) == 0; i++);
+    bench::check(small_settings["a"]["y"].empty(), "key removed from the file is still there");
+    bench::check(static_cast<long>(small_settings["a"]["z"].value()) == 30, "unsaved change was overwritten by a reload");
+
+    // a lazy value that does not decode differs from the file, it is replaced with the rest instead of stopping the reload halfway
+    dot::load_options lazy;
+    lazy.lazy = true;
+    const auto broken = bench::write_temp("watch_broken.ini", "[a]\nx = 1\ny = (1, 2\n");
+    dot::settings broken_settings(broken, lazy);
+    replace_file(broken, "[a]\nx = 5\ny = (1, 2)\n");
+    size_t reloaded = 0;
+    try { reloaded = broken_settings.reload(); }
+    catch(const std::runtime_error&) {}
+    bench::check(reloaded == 2 and static_cast<long>(broken_settings["a"]["x"].value()) == 5 and broken_settings["a"]["y"].is_tuple(), "a broken lazy value stopped the reload");
+}
+
+static bench::registrar registered("watch", watch);
@@ -0,0 +1,113 @@
+//============================================================================
+// @name        : writeback.cpp
+// @description : cost of destroying a settings that changed nothing, one key or everything, and what the patched file keeps
+//============================================================================
+
+#include "bench.h"
+#include "../src/settings.h"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void writeback()
+{
+    const auto data = bench::generate({100, 22000});
+    const auto path = bench::write_temp("writeback.ini", data);
+    std::printf("file size: %zu MB\n", data.size() >> 20);
+
+    const auto destroy = [&](const std::string& name, const std::function<void(dot::settings&)>& change)
+    {
+        auto settings = new dot::settings(path);
+        change(*settings);
+        bench::report(name, bench::time([&](){ delete settings; }), data.size());
+    };
+
+    destroy("destroy unchanged", [](dot::settings&){});
+    destroy("destroy one key changed", [](dot::settings& settings){ settings["Section50"][bench::key_name(7)].change(42); });
+
+    // what every destruction did before: print the whole tree into the file
+    auto settings = new dot::settings(path);
+    bench::report("full rewrite", bench::time([&](){ std::ofstream(path) << *settings; }), data.size());
+    delete settings;
+
+    // comments, blank lines and the formatting of untouched values survive a change
+    const std::string original = "# header\n[a]\nx =   1\n; about y\ny = [1,2,3]\nz = \"old\"\n\n[b]\nk = 0x10\n";
+    const auto small = bench::write_temp("writeback_small.ini", original);
+    {
+        dot::settings changed(small);
+        changed["a"]["z"].change("new");
+        changed["a"]["y"].erase();
+        changed["b"]["added"].write(true);
+        changed["c"]["fresh"].write(1, 2);
+    }
+    const auto patched = "# header\n[a]\nx =   1\n; about y\nz = \"new\"\n\n[b]\nk = 0x10\nadded = true\n\n[c]\nfresh = [1, 2]\n\n";
+    bench::check(bench::read_file(small) == patched, "patched file differs:\n" + bench::read_file(small));
+
+    {
+        dot::settings unchanged(small);
+        bench::do_not_optimize(unchanged["a"]["x"].value().index());
+    }
+    bench::check(bench::read_file(small) == patched, "unchanged settings rewrote its file");
+
+    // every line of a key that is in a section more than once is changed, and added lines end like the others
+    const auto repeated = bench::write_temp("writeback_repeated.ini", "[S]\r\nk = 1\r\nj = 2\r\nk = 3\r\nm = 4\r\nm = 5\r\n");
+    {
+        dot::settings changed(repeated);
+        changed["S"]["k"].erase();
+        changed["S"]["m"].change(6);
+        changed["S"]["n"].write(7);
+        changed["T"]["o"].write(8);
+    }
+    const auto repeated_patched = "[S]\r\nj = 2\r\nm = 6\r\nn = 7\r\n\r\n[T]\r\no = 8\r\n\r\n";
+    bench::check(bench::read_file(repeated) == repeated_patched, "patched file with repeated keys differs:\n" + bench::read_file(repeated));
+
+    // a symlink is written through and the file keeps its owner and permissions
+    const auto real = bench::write_temp("writeback_real.ini", "[a]\nx = 1\n");
+    const auto link = real.substr(0, real.rfind('/') + 1) + "dot_bench_writeback_link.ini";
+    std::filesystem::remove(link);
+    std::filesystem::create_symlink(real, link);
+    chmod(real.c_str(), 0640);
+    const auto owner = (geteuid() == 0) ? uid_t(1234) : geteuid();
+    if(geteuid() == 0 and chown(real.c_str(), owner, gid_t(1234)) != 0) bench::check(false, "could not chown the file");
+    {
+        dot::settings linked(link);
+        linked["a"]["x"].change(2);
+    }
+    struct stat info{};
+    stat(real.c_str(), &info);
+    bench::check(std::filesystem::is_symlink(link) and bench::read_file(real) == "[a]\nx = 2\n", "the symlink was replaced instead of written through");
+    bench::check((info.st_mode & 07777) == 0640 and info.st_uid == owner, "the file lost its owner or permissions");
+
+    // saves of one file from several settings at once each write their own temporary file, the last rename wins whole
+    const auto shared = bench::write_temp("writeback_shared.ini", "[a]\nx = 0\n");
+    std::vector<std::thread> savers;
+    for(long t = 1; t <= 4; t++)
+    {
+        savers.emplace_back([&shared, t]()
+        {
+            for(long i = 0; i < 20; i++)
+            {
+                dot::settings saving(shared);
+                saving["a"]["x"].change(t * 100 + i);
+                saving["a"]["padding" + std::to_string(t)].write_or_change(std::string(4096, 'p'));
+            }
+        });
+    }
+    for(auto& saver : savers) saver.join();
+
+    bool parsed = false;
+    try { parsed = static_cast<long>(dot::settings(shared)["a"]["x"].value()) % 100 == 19; }
+    catch(const std::runtime_error&) {}
+    const auto directory = std::filesystem::path(shared).parent_path();
+    const auto leftovers = std::count_if(std::filesystem::directory_iterator(directory), {}, [&](const auto& file)
+    {
+        return file.path().string().rfind(shared + ".", 0) == 0;
+    });
+    bench::check(parsed and leftovers == 0, "concurrent saves of one file mixed their output or left temporary files");
+}
+
+static bench::registrar registered("writeback", writeback);
@@ -0,0 +1,81 @@
+//============================================================================
+// @name        : concurrent_settings.cpp
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description :
+//============================================================================
+
+#include "concurrent_settings.h"
+
+#include <thread>
+
+dot::concurrent_settings::concurrent_settings(std::string path, load_options options)
+    : master(std::move(path), options), current(new settings(master.copy())) {}
+
+dot::concurrent_settings::~concurrent_settings()
+{
+    delete current.load();
+    for(const auto snapshot : retired) delete snapshot;
+}
+
+dot::concurrent_settings::reader::~reader()
+{
+    if(hazard == nullptr) return;
+    hazard->snapshot.store(nullptr, std::memory_order_release);
+    hazard->used.store(false, std::memory_order_release);
+}
+
+dot::concurrent_settings::reader dot::concurrent_settings::read() const
+{
+    // threads start looking for a free slot at different places and keep the last one they got
+    thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    slot* hazard = nullptr;
+    for(auto i = hint % slots.size();; i = (i + 1) % slots.size())
+    {
+        auto& candidate = slots[i];
+        if(not candidate.used.load(std::memory_order_relaxed) and not candidate.used.exchange(true, std::memory_order_acquire))
+        {
+            hint = i;
+            hazard = &candidate;
+            break;
+        }
+    }
+
+    // the snapshot is only safe once it is announced while it is still the current one, a writer may have swapped it in between
+    const settings* snapshot = current.load();
+    while(true)
+    {
+        hazard->snapshot.store(snapshot);
+        const auto again = current.load();
+        if(again == snapshot) break;
+        snapshot = again;
+    }
+    return reader(hazard, snapshot);
+}
+
+void dot::concurrent_settings::write(const std::function<void(settings&)>& fn)
+{
+    std::lock_guard lock(writer);
+    fn(master);
+
+    const auto next = new settings(master.copy());
+    retired.push_back(current.exchange(next));
+    reclaim();
+}
+
+void dot::concurrent_settings::reclaim()
+{
+    std::vector<const settings*> used;
+    for(const auto& hazard : slots)
+    {
+        if(const auto snapshot = hazard.snapshot.load(); snapshot != nullptr) used.push_back(snapshot);
+    }
+
+    const auto in_use = [&](const settings* snapshot){ return std::find(used.begin(), used.end(), snapshot) != used.end(); };
+    const auto free = std::stable_partition(retired.begin(), retired.end(), in_use);
+    for(auto it = free; it != retired.end(); it++) delete *it;
+    retired.erase(free, retired.end());
+}
@@ -0,0 +1,81 @@
+//============================================================================
+// @name        : concurrent_settings.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : settings that many threads read while one changes them
+//============================================================================
+
+
+#pragma once
+
+#include "settings.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace dot
+{
+    // Readers get an immutable snapshot without taking a lock, writers change a private copy and publish a new snapshot.
+    // An old snapshot is deleted once no reader holds it any more, readers announce the snapshot they use in a hazard slot.
+    // There are 128 slots, a reader beyond that spins until another one is done.
+    class concurrent_settings
+    {
+        struct alignas(64) slot
+        {
+            std::atomic<bool> used = false;
+            std::atomic<const settings*> snapshot = nullptr;
+        };
+
+    public:
+        // keeps one snapshot alive while it exists, hold it only as long as needed as it keeps older versions from being freed
+        class reader
+        {
+        public:
+            reader(reader&& other) noexcept : hazard(std::exchange(other.hazard, nullptr)), snapshot(other.snapshot) {}
+            reader(const reader&) = delete;
+            reader& operator=(const reader&) = delete;
+            reader& operator=(reader&&) = delete;
+            ~reader();
+
+            [[nodiscard]] const settings& operator*() const noexcept { return *snapshot; }
+            [[nodiscard]] const settings* operator->() const noexcept { return snapshot; }
+            [[nodiscard]] const section& operator[](dot::key key) const { return (*snapshot)[key]; }
+
+        private:
+            friend class concurrent_settings;
+            reader(slot* used, const settings* version) noexcept : hazard(used), snapshot(version) {}
+
+            slot* hazard;
+            const settings* snapshot;
+        };
+
+        explicit concurrent_settings(std::string path, load_options options = {});
+
+        // no reader may outlive it
+        ~concurrent_settings();
+
+        concurrent_settings(const concurrent_settings&) = delete;
+        concurrent_settings& operator=(const concurrent_settings&) = delete;
+
+        [[nodiscard]] reader read() const;
+
+        // runs fn on the settings that owns the file, under a lock shared by all writers, and publishes a copy of the result.
+        // callbacks of changed entries run inside fn, on the writing thread. changes are written to the file on destruction.
+        void write(const std::function<void(settings&)>& fn);
+
+    private:
+        void reclaim();
+
+        settings master;
+        std::atomic<const settings*> current;
+
+        std::mutex writer;
+        std::vector<const settings*> retired;
+
+        mutable std::array<slot, 128> slots;
+    };
+}
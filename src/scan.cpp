@@ -0,0 +1,253 @@
+//============================================================================
+// @name        : scan.cpp
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description :
+//============================================================================
+
+#include "scan.h"
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <immintrin.h>
+#define DOT_SCAN_X86 1
+#endif
+
+namespace
+{
+    constexpr bool is_whitespace(char c) noexcept
+    {
+        return c == ' ' or c == '\t' or c == '\r';
+    }
+
+    constexpr bool is_alphanumeric(char c) noexcept
+    {
+        return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9');
+    }
+
+    template<typename Predicate>
+    const char* scalar_find(const char* begin, const char* end, Predicate predicate) noexcept
+    {
+        for(; begin != end; begin++)
+        {
+            if(predicate(*begin)) return begin;
+        }
+        return end;
+    }
+
+    const char* scalar_newline(const char* begin, const char* end) noexcept
+    {
+        return scalar_find(begin, end, [](char c){ return c == '\n'; });
+    }
+
+    const char* scalar_quote(const char* begin, const char* end) noexcept
+    {
+        return scalar_find(begin, end, [](char c){ return c == '"'; });
+    }
+
+    const char* scalar_not_whitespace(const char* begin, const char* end) noexcept
+    {
+        return scalar_find(begin, end, [](char c){ return not is_whitespace(c); });
+    }
+
+    const char* scalar_not_alphanumeric(const char* begin, const char* end) noexcept
+    {
+        return scalar_find(begin, end, [](char c){ return not is_alphanumeric(c); });
+    }
+
+#ifdef DOT_SCAN_X86
+    // Block has to provide: a vector type, its width, load, and a mask of matching bytes.
+    // full blocks are checked with the vector code, the tail falls back to the scalar predicate.
+    template<typename Block, typename Predicate>
+    inline const char* vector_find(const char* begin, const char* end, Predicate predicate) noexcept
+    {
+        while(end - begin >= Block::width)
+        {
+            const auto mask = Block::match(Block::load(begin));
+            if(mask != 0) return begin + __builtin_ctz(mask);
+            begin += Block::width;
+        }
+        return scalar_find(begin, end, predicate);
+    }
+
+    struct sse2_block
+    {
+        static constexpr std::ptrdiff_t width = 16;
+
+        static __m128i load(const char* pointer) noexcept
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pointer));
+        }
+
+        static unsigned mask(__m128i value) noexcept
+        {
+            return static_cast<unsigned>(_mm_movemask_epi8(value));
+        }
+
+        static __m128i equal(__m128i value, char c) noexcept
+        {
+            return _mm_cmpeq_epi8(value, _mm_set1_epi8(c));
+        }
+
+        // lo <= value <= hi, bytes >= 0x80 compare as negative and never match
+        static __m128i in_range(__m128i value, char lo, char hi) noexcept
+        {
+            const auto above = _mm_cmpgt_epi8(value, _mm_set1_epi8(static_cast<char>(lo - 1)));
+            const auto below = _mm_cmplt_epi8(value, _mm_set1_epi8(static_cast<char>(hi + 1)));
+            return _mm_and_si128(above, below);
+        }
+
+        static __m128i whitespace(__m128i value) noexcept
+        {
+            return _mm_or_si128(_mm_or_si128(equal(value, ' '), equal(value, '\t')), equal(value, '\r'));
+        }
+
+        static __m128i alphanumeric(__m128i value) noexcept
+        {
+            const auto lower = _mm_or_si128(value, _mm_set1_epi8(0x20));
+            return _mm_or_si128(in_range(lower, 'a', 'z'), in_range(value, '0', '9'));
+        }
+    };
+
+    template<char C>
+    struct sse2_equal : sse2_block
+    {
+        static unsigned match(__m128i value) noexcept { return mask(equal(value, C)); }
+    };
+
+    struct sse2_not_whitespace : sse2_block
+    {
+        static unsigned match(__m128i value) noexcept { return ~mask(whitespace(value)) & 0xffffu; }
+    };
+
+    struct sse2_not_alphanumeric : sse2_block
+    {
+        static unsigned match(__m128i value) noexcept { return ~mask(alphanumeric(value)) & 0xffffu; }
+    };
+
+    const char* sse2_newline(const char* begin, const char* end) noexcept
+    {
+        return vector_find<sse2_equal<'\n'>>(begin, end, [](char c){ return c == '\n'; });
+    }
+
+    const char* sse2_quote(const char* begin, const char* end) noexcept
+    {
+        return vector_find<sse2_equal<'"'>>(begin, end, [](char c){ return c == '"'; });
+    }
+
+    const char* sse2_not_whitespace_find(const char* begin, const char* end) noexcept
+    {
+        return vector_find<sse2_not_whitespace>(begin, end, [](char c){ return not is_whitespace(c); });
+    }
+
+    const char* sse2_not_alphanumeric_find(const char* begin, const char* end) noexcept
+    {
+        return vector_find<sse2_not_alphanumeric>(begin, end, [](char c){ return not is_alphanumeric(c); });
+    }
+
+#define DOT_AVX2 __attribute__((target("avx2")))
+
+    // the avx2 versions are written out instead of shared through templates,
+    // so every intrinsic ends up inside a function that is compiled for avx2
+    DOT_AVX2 inline __m256i avx2_load(const char* pointer) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointer));
+    }
+
+    DOT_AVX2 inline unsigned avx2_mask(__m256i value) noexcept
+    {
+        return static_cast<unsigned>(_mm256_movemask_epi8(value));
+    }
+
+    DOT_AVX2 inline __m256i avx2_equal(__m256i value, char c) noexcept
+    {
+        return _mm256_cmpeq_epi8(value, _mm256_set1_epi8(c));
+    }
+
+    DOT_AVX2 inline __m256i avx2_in_range(__m256i value, char lo, char hi) noexcept
+    {
+        const auto above = _mm256_cmpgt_epi8(value, _mm256_set1_epi8(static_cast<char>(lo - 1)));
+        const auto below = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), value);
+        return _mm256_and_si256(above, below);
+    }
+
+    DOT_AVX2 const char* avx2_newline(const char* begin, const char* end) noexcept
+    {
+        for(; end - begin >= 32; begin += 32)
+        {
+            const auto mask = avx2_mask(avx2_equal(avx2_load(begin), '\n'));
+            if(mask != 0) return begin + __builtin_ctz(mask);
+        }
+        return sse2_newline(begin, end);
+    }
+
+    DOT_AVX2 const char* avx2_quote(const char* begin, const char* end) noexcept
+    {
+        for(; end - begin >= 32; begin += 32)
+        {
+            const auto mask = avx2_mask(avx2_equal(avx2_load(begin), '"'));
+            if(mask != 0) return begin + __builtin_ctz(mask);
+        }
+        return sse2_quote(begin, end);
+    }
+
+    DOT_AVX2 const char* avx2_not_whitespace(const char* begin, const char* end) noexcept
+    {
+        for(; end - begin >= 32; begin += 32)
+        {
+            const auto value = avx2_load(begin);
+            const auto whitespace = _mm256_or_si256(_mm256_or_si256(avx2_equal(value, ' '), avx2_equal(value, '\t')), avx2_equal(value, '\r'));
+            const auto mask = ~avx2_mask(whitespace);
+            if(mask != 0) return begin + __builtin_ctz(mask);
+        }
+        return sse2_not_whitespace_find(begin, end);
+    }
+
+    DOT_AVX2 const char* avx2_not_alphanumeric(const char* begin, const char* end) noexcept
+    {
+        for(; end - begin >= 32; begin += 32)
+        {
+            const auto value = avx2_load(begin);
+            const auto lower = _mm256_or_si256(value, _mm256_set1_epi8(0x20));
+            const auto alphanumeric = _mm256_or_si256(avx2_in_range(lower, 'a', 'z'), avx2_in_range(value, '0', '9'));
+            const auto mask = ~avx2_mask(alphanumeric);
+            if(mask != 0) return begin + __builtin_ctz(mask);
+        }
+        return sse2_not_alphanumeric_find(begin, end);
+    }
+
+#undef DOT_AVX2
+
+    const dot::scan::scanner sse2_scanner{"sse2", sse2_newline, sse2_quote, sse2_not_whitespace_find, sse2_not_alphanumeric_find};
+    const dot::scan::scanner avx2_scanner{"avx2", avx2_newline, avx2_quote, avx2_not_whitespace, avx2_not_alphanumeric};
+#endif
+}
+
+const dot::scan::scanner dot::scan::scalar{"scalar", scalar_newline, scalar_quote, scalar_not_whitespace, scalar_not_alphanumeric};
+
+const dot::scan::scanner* dot::scan::sse2() noexcept
+{
+#ifdef DOT_SCAN_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2") ? &sse2_scanner : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const dot::scan::scanner* dot::scan::avx2() noexcept
+{
+#ifdef DOT_SCAN_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? &avx2_scanner : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+const dot::scan::scanner& dot::scan::best() noexcept
+{
+    static const scanner& result = avx2() ? *avx2() : sse2() ? *sse2() : scalar;
+    return result;
+}
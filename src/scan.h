@@ -0,0 +1,36 @@
+//============================================================================
+// @name        : scan.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : byte scanning primitives used by the parser, with sse2 and avx2
+//                versions that are picked at runtime
+//============================================================================
+
+
+#pragma once
+
+#include <cstddef>
+
+namespace dot::scan
+{
+    // every function returns the first position in [begin, end) that matches, or end
+    struct scanner
+    {
+        const char* name;
+        const char* (*find_newline)(const char* begin, const char* end) noexcept;
+        const char* (*find_quote)(const char* begin, const char* end) noexcept;
+        const char* (*find_not_whitespace)(const char* begin, const char* end) noexcept;
+        const char* (*find_not_alphanumeric)(const char* begin, const char* end) noexcept;
+    };
+
+    extern const scanner scalar;
+
+    // nullptr when the cpu or compiler does not support it
+    [[nodiscard]] const scanner* sse2() noexcept;
+    [[nodiscard]] const scanner* avx2() noexcept;
+
+    // the widest supported scanner, chosen once at startup
+    [[nodiscard]] const scanner& best() noexcept;
+}
@@ -0,0 +1,145 @@
+//============================================================================
+// @name        : schema.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : fills a struct straight from an ini file, for a set of keys known at compile time
+//============================================================================
+
+
+#pragma once
+
+#include "settings.h"
+
+#include <tuple>
+
+namespace dot
+{
+    // a member of Struct that is read from a key in a section
+    template<typename Struct, typename Member>
+    struct field
+    {
+        constexpr field(dot::key section_name, dot::key key_name, Member Struct::* target) noexcept : section(section_name), name(key_name), member(target) {}
+
+        dot::key section;
+        dot::key name;
+        Member Struct::* member;
+    };
+
+    // The file is tokenized once and only the values of the fields are decoded, no sections or entries are built.
+    // Fields that are not in the file keep the value they have in a default constructed Struct, other keys are skipped.
+    // A value of the wrong type, an integer that does not fit its field or a variable before the first section is an error with its line.
+    // Integers are accepted for floating point fields.
+    //
+    // static constexpr dot::schema config_schema{ dot::field{"server", "port", &config::port}, ... };
+    // config result = config_schema.load("config.ini");
+    template<typename Struct, typename... Members>
+    class schema
+    {
+    public:
+        constexpr schema(field<Struct, Members>... all) noexcept : fields(all...) {}
+
+        [[nodiscard]] Struct load(const std::string& path) const
+        {
+            const auto data = iniparser::read_to_string(path);
+            return parse(data);
+        }
+
+        [[nodiscard]] Struct parse(std::string_view data) const
+        {
+            Struct result{};
+            parse(data, result);
+            return result;
+        }
+
+        void parse(std::string_view data, Struct& result) const
+        {
+            binder handler(*this, result);
+            iniparser::tokenize(data.data(), data.data() + data.size(), handler);
+        }
+
+    private:
+        struct binder final : iniparser::handler
+        {
+            binder(const schema& owner, Struct& target) : self(owner), result(target) {}
+
+            void on_section(std::string_view name, int) override
+            {
+                section = dot::key(name);
+                in_section = true;
+            }
+
+            void on_variable(std::string_view name, std::string_view value, int line) override
+            {
+                if(not in_section) iniparser::error("variable has no section", line);
+
+                const auto key = dot::key(name);
+                std::apply([&](const auto&... all){ (bind(all, key, value, line) or ...); }, self.fields);
+            }
+
+            template<typename Member>
+            bool bind(const field<Struct, Member>& field, dot::key key, std::string_view value, int line)
+            {
+                if(field.name.hash != key.hash or field.section.hash != section.hash) return false;
+                if(field.name.name != key.name or field.section.name != section.name) return false;
+
+                decode(result.*(field.member), field, value, line);
+                return true;
+            }
+
+            const schema& self;
+            Struct& result;
+            dot::key section = dot::key(std::string_view());
+            // an empty name is a section too, "[]" is valid
+            bool in_section = false;
+        };
+
+        template<typename Member>
+        static void decode(Member& member, const field<Struct, Member>& field, std::string_view value, int line)
+        {
+            auto parsed = settings::parse_value(value, line);
+            auto& variable = parsed.variable;
+
+            if constexpr(std::is_floating_point_v<Member>)
+            {
+                if(const auto number = variable.template get_if<long>())
+                {
+                    member = static_cast<Member>(*number);
+                    return;
+                }
+            }
+
+            const auto stored = variable.template get_if<stored_type_t<Member>>();
+            if(stored == nullptr)
+            {
+                const auto message = "expected " + type_name<Member>() + " for " + std::string(field.section.name) + '.' + std::string(field.name.name);
+                iniparser::error(message.c_str(), line);
+            }
+
+            if      constexpr(std::is_same_v<Member, std::vector<bool>>) member = std::move(stored->get());
+            else if constexpr(std::is_same_v<Member, stored_type_t<Member>>) member = std::move(*stored);
+            else if constexpr(std::is_integral_v<Member>)
+            {
+                // an integer that does not fit the member is an error instead of wrapping around
+                const auto narrowed = static_cast<Member>(*stored);
+                if(static_cast<long>(narrowed) != *stored or (std::is_unsigned_v<Member> and *stored < 0))
+                {
+                    const auto message = "integer out of range for " + std::string(field.section.name) + '.' + std::string(field.name.name);
+                    iniparser::error(message.c_str(), line);
+                }
+                member = narrowed;
+            }
+            else member = static_cast<Member>(*stored);
+        }
+
+        template<typename Member>
+        static std::string type_name()
+        {
+            constexpr const char* names[] = {"", "bool", "a number", "an integer", "a string", "a list of bools", "a list of numbers", "a list of integers", "a list of strings", "a tuple"};
+            return names[stored_index<Member>()];
+        }
+
+        std::tuple<field<Struct, Members>...> fields;
+    };
+}
@@ -8,6 +8,73 @@
 //============================================================================
 
 #include "settings.h"
+#include "scan.h"
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+dot::mapped_file::mapped_file(const std::string& path)
+{
+    const auto file = open(path.c_str(), O_RDONLY);
+    if(file < 0) throw std::runtime_error("could not open file: " + path);
+
+    struct stat info{};
+    if(fstat(file, &info) != 0)
+    {
+        close(file);
+        throw std::runtime_error("could not stat file: " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    if(length != 0)
+    {
+        void* result = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file, 0);
+        if(result == MAP_FAILED)
+        {
+            close(file);
+            throw std::runtime_error("could not map file: " + path);
+        }
+        madvise(result, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(result);
+    }
+    released = data;
+    close(file);
+}
+
+dot::mapped_file::~mapped_file()
+{
+    if(data != nullptr) munmap(const_cast<char*>(data), length);
+}
+
+void dot::mapped_file::release(iterator position) noexcept
+{
+    // only whole pages can be dropped, the values in them have been copied out already
+    const auto page = static_cast<std::ptrdiff_t>(sysconf(_SC_PAGESIZE));
+    const auto count = (position - data) / page * page;
+    const auto first = released - data;
+    if(count <= first) return;
+
+    madvise(const_cast<char*>(released), static_cast<size_t>(count - first), MADV_DONTNEED);
+    released = data + count;
+}
+
+//------------------------------------------------//
 
 [[nodiscard]] std::string dot::iniparser::read_to_string(const std::string& path)
 {
@@ -18,8 +85,9 @@
     fseek(file, 0, SEEK_SET);
 
     std::string string(size, 0);
-    fread(string.data(), 1, size, file);
+    const auto read = fread(string.data(), 1, size, file);
     fclose(file);
+    if(read != size) throw std::runtime_error("could not read file: " + path);
     return string;
 }
 
@@ -40,209 +108,1673 @@
 
 [[nodiscard]] dot::iterator dot::iniparser::skip_whitespace(iterator begin, iterator end) noexcept
 {
-    for(; begin != end; begin++)
-    {
-        if(not is_whitespace(*begin)) return begin;
-    }
-    return end;
+    return scan::best().find_not_whitespace(begin, end);
 }
 
-[[nodiscard]] inline dot::iterator dot::iniparser::find_token_end(iterator begin, iterator end) noexcept
+[[nodiscard]] dot::iterator dot::iniparser::find_token_end(iterator begin, iterator end) noexcept
 {
-    for(; begin != end; begin++)
-    {
-        if(not (is_character(*begin) or is_number(*begin))) return begin;
-    }
-    return end;
+    return scan::best().find_not_alphanumeric(begin, end);
 }
 
-[[nodiscard]] inline dot::iterator dot::iniparser::skip_line(iterator begin, iterator end) noexcept
+[[nodiscard]] dot::iterator dot::iniparser::skip_line(iterator begin, iterator end) noexcept
 {
-    for(; begin != end-1; begin++)
-    {
-        if(*begin == '\n') return ++begin;
-    }
-    return end;
+    const auto newline = scan::best().find_newline(begin, end);
+    return (newline == end) ? end : newline + 1;
 }
 
-[[nodiscard]] inline dot::iterator dot::iniparser::skip_line(iterator begin) noexcept
+[[nodiscard]] std::pair<dot::iterator, bool> dot::iniparser::skip_empty_line(iterator begin, iterator end) noexcept
 {
-    for(; *begin != '\0'; begin++)
+    const auto first = skip_whitespace(begin, end);
+    if(first == end) return {end, true};
+    if(*first == '\n') return {first + 1, true};
+    return {skip_line(first, end), false};
+}
+
+[[nodiscard]] dot::iterator dot::iniparser::find_string_end(dot::iterator begin, dot::iterator end) noexcept
+{
+    begin++;
+    while(true)
     {
-        if(*begin == '\n') return ++begin;
+        const auto quote = scan::best().find_quote(begin, end);
+        if(quote == end) return end;
+        if(*(quote-1) != '\\') return quote + 1;
+        begin = quote + 1;
     }
-    return begin;
 }
 
-[[nodiscard]] inline std::pair<dot::iterator, bool> dot::iniparser::skip_empty_line(iterator begin, iterator end) noexcept
+//------------------------------------------------//
+
+dot::inibuffer& dot::inibuffer::operator<<(long value)
+{
+    char buffer[24];
+    const auto end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    data.append(buffer, static_cast<size_t>(end - buffer));
+    return *this;
+}
+
+dot::inibuffer& dot::inibuffer::operator<<(double value)
+{
+    char buffer[32];
+    return *this << iniprinter::format(value, buffer);
+}
+
+std::string_view dot::iniprinter::format(double value, char (&buffer)[32]) noexcept
 {
-    bool is_empty = true;
-    for(; begin != end-1; begin++)
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer) - 2, value).ptr;
+    const auto text = std::string_view(buffer, static_cast<size_t>(end - buffer));
+
+    // inf and nan have an 'n' and no digits to add to
+    if(text.find_first_of(".en") == std::string_view::npos)
     {
-        if(*begin == '\n') return {++begin, is_empty};
-        if(not is_whitespace(*begin)) is_empty = false;
+        *end++ = '.';
+        *end++ = '0';
     }
-    return {end, is_empty};
+    return std::string_view(buffer, static_cast<size_t>(end - buffer));
 }
 
-[[nodiscard]] inline dot::iterator dot::iniparser::find_string_end(dot::iterator begin, dot::iterator end) noexcept
+dot::inibuffer& dot::iniprinter::print(inibuffer& buffer, std::string_view name, const section& section)
 {
-    begin++;
-    for(; begin != end; begin++)
+    const auto start = buffer.size();
+    buffer << '[' << name << "]\n";
+    const auto header = buffer.size();
+
+    for(const auto& elem : section)
     {
-        if(*begin == '"' and *(begin-1) != '\\') return ++begin;
+        if(elem.second.empty()) continue;
+        buffer << elem.first << " = ";
+        print(buffer, elem.second) << '\n';
     }
-    return end;
+
+    if(buffer.size() == header) buffer.truncate(start);
+    else buffer << '\n';
+    return buffer;
 }
 
 //------------------------------------------------//
 
-dot::settings::settings(std::string file_path) : path(std::move(file_path))
+namespace
 {
-    const std::string data = iniparser::read_to_string(path);
-    const auto end = data.end();
+    // writes the whole contents, in as few write calls as the kernel allows, to a new file with a unique name next to path.
+    // returns that name, or an empty string with errno set when it could not be written. durable waits until the contents are on disk.
+    // mkstemp makes the file only readable by its owner, so it gets mode instead, without the umask.
+    std::string write_temp(const std::string& path, std::string_view data, mode_t mode, bool durable = false)
+    {
+        auto temp = path + ".XXXXXX";
+        const auto file = mkstemp(temp.data());
+        if(file < 0) return {};
+
+        while(not data.empty())
+        {
+            const auto written = write(file, data.data(), data.size());
+            if(written < 0 and errno == EINTR) continue;
+            if(written <= 0) break;
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+        const auto complete = data.empty() and fchmod(file, mode) == 0 and (not durable or fsync(file) == 0);
+        if(close(file) == 0 and complete) return temp;
 
-    auto current = data.begin();
-    auto line = 1;
+        const auto failure = errno;
+        unlink(temp.c_str());
+        errno = failure;
+        return {};
+    }
 
-    while(true)
+    // makes a rename in the directory of the file survive a crash
+    void sync_directory(const std::string& path)
     {
-        if(*current == '[')
-        {
-            const auto next = iniparser::find_token_end(++current, end);
-            if( next == end) error("file end before closing ]", line);
-            if(*next != ']') error("did not find closing ] after section name", line);
+        const auto parent = std::filesystem::path(path).parent_path();
+        const auto directory = open(parent.empty() ? "." : parent.c_str(), O_RDONLY | O_DIRECTORY);
+        if(directory < 0) return;
+        fsync(directory);
+        close(directory);
+    }
 
-            const auto name = std::string(current, next);
-            const auto result = map.emplace_back(name, dot::section());
-            const auto iter = std::find_if(map.begin(), map.end(), [name](const auto& elem){ return elem.first == name; });
-            if(iter == map.end()) error("duplicate section name: ", current, next, line);
+    // the kind of a decoded value and the heap allocations it made, for dot::stats
+    void count_value(dot::stats& counted, const dot::inivariable& variable)
+    {
+        const auto allocated = [](const std::string& string){ return string.capacity() > std::string().capacity() ? 1u : 0u; };
 
-            const auto line_end = iniparser::skip_empty_line(next+1, end);
-            if(not line_end.second) error("symbols found after section name", next+1, line_end.first-1, line);
-            else current = line_end.first;
+        if(const auto string = variable.get_if<std::string>())
+        {
+            counted.strings++;
+            counted.allocations += allocated(*string);
         }
-        else if(*current == '#' or *current == ';')
+        else if(const auto strings = variable.get_if<std::vector<std::string>>())
+        {
+            counted.vectors++;
+            counted.allocations++;
+            for(const auto& elem : *strings) counted.allocations += allocated(elem);
+        }
+        else if(const auto tuple = variable.get_if<std::vector<dot::inivariable::ini_tuple_element>>())
         {
-            current = iniparser::skip_line(current, end);
+            counted.tuples++;
+            counted.allocations++;
+            for(const auto& elem : *tuple)
+            {
+                if(const auto text = std::get_if<std::string>(&elem)) counted.allocations += allocated(*text);
+            }
         }
-        else if(iniparser::is_whitespace(*current) or *current == '\n')
+        else if(variable.get_if<dot::boxed<std::vector<bool>>>() != nullptr)
         {
-            auto result = iniparser::skip_empty_line(current, end);
-            if(not result.second) error("please do not use whitespace before data", line);
-            else current = result.first;
+            counted.vectors++;
+            counted.allocations += 2;
         }
-        else if(iniparser::is_character(*current))
+        else if(variable.index() > 4)
         {
-            if(map.empty()) error("variable has no section", line);
-
-            const auto token_end = iniparser::find_token_end(current, end);
+            counted.vectors++;
+            counted.allocations++;
+        }
+    }
 
-            const auto var_begin = iniparser::skip_whitespace(token_end, end);
-            if(*var_begin != '=') error("could not find '='", line);
-            auto current_var = iniparser::skip_whitespace(var_begin+1, end);
+    // runs fn(0) ... fn(count-1) on up to threads workers, exceptions are rethrown in index order once all are done
+    void parallel_for(size_t count, unsigned threads, const std::function<void(size_t)>& fn)
+    {
+        if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        const auto workers = std::min<size_t>(threads, count);
 
+        std::vector<std::exception_ptr> errors(count);
+        std::atomic<size_t> next = 0;
 
-            if(*current_var == '(' or *current_var == '[')
+        const auto work = [&]()
+        {
+            for(auto i = next++; i < count; i = next++)
             {
-                std::vector<inivariable::ini_tuple_element> tuple;
-                bool done = false;
-                bool is_tuple = *current_var == '(';
+                try { fn(i); }
+                catch(...) { errors[i] = std::current_exception(); }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for(size_t i = 1; i < workers; i++) pool.emplace_back(work);
+        work();
+        for(auto& thread : pool) thread.join();
+
+        for(const auto& error : errors)
+        {
+            if(error) std::rethrow_exception(error);
+        }
+    }
+}
+
+class dot::settings::flusher
+{
+public:
+    static flusher& instance()
+    {
+        static flusher result;
+        return result;
+    }
+
+    // waits for the pending writes of the file, without starting the worker when nothing was ever saved in the background
+    static void wait_for(const std::string& file)
+    {
+        if(started.load()) instance().wait(file);
+    }
 
-                while(not done)
+    // the snapshot replaces the one of a pending write of the same file, which then waits for the debounce delay again.
+    // without a snapshot it only waits for the pending writes of the file. the future is only valid when wanted.
+    std::future<void> schedule(const std::string& file, std::optional<settings> snapshot, std::chrono::milliseconds delay, error_handler on_error, bool wanted)
+    {
+        std::future<void> result;
+        {
+            std::lock_guard lock(mutex);
+            auto pending = std::find_if(jobs.begin(), jobs.end(), [&](const job& data){ return data.file == file; });
+            if(pending == jobs.end())
+            {
+                if(not snapshot and writing != file)
                 {
-                    auto&& [new_done, var] = parse_tuple_element(current_var, end, line, (is_tuple) ? ')' : ']');
-                    tuple.emplace_back(std::forward<inivariable::ini_tuple_element>(var));
-                    done = new_done;
+                    std::promise<void> done;
+                    done.set_value();
+                    return done.get_future();
                 }
-                map.back().second[std::string(current, token_end)] = entry(tuple, is_tuple);
-                current = current_var + 1;
+                pending = jobs.insert(jobs.end(), job{file, std::nullopt, clock::now(), {}, {}, false});
             }
-            else
+
+            if(snapshot)
             {
-                auto&& [next, variable] = parse_variable(current_var, end, line);
-                map.back().second[std::string(current, token_end)] = entry(variable);
-                current = next;
+                // the entries saved by the replaced snapshot are written by this one
+                if(pending->snapshot) snapshot->take_dirty(*pending->snapshot);
+                pending->snapshot = std::move(snapshot);
+                pending->due = clock::now() + delay;
             }
-            auto&& [end_line, is_empty] = iniparser::skip_empty_line(current, end);
-            if(not is_empty) error("line not empty after variable", line);
-            current = end_line;
+            pending->on_error = std::move(on_error);
+            pending->unwanted |= not wanted;
+            if(wanted) result = pending->waiting.emplace_back().get_future();
         }
-        else throw std::runtime_error(std::string("please do not use: \"") + *current + "\" as the start of a line");
+        wake.notify_one();
+        return result;
+    }
+
+    // blocks until no write of the file is pending
+    void wait(const std::string& file)
+    {
+        std::unique_lock lock(mutex);
+        written.wait(lock, [&]
+        {
+            return writing != file and std::none_of(jobs.begin(), jobs.end(), [&](const job& data){ return data.file == file; });
+        });
+    }
+
+    // the writes that are still pending are made at once
+    ~flusher()
+    {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
 
-        if(current == end) return;
-        line++;
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct job
+    {
+        std::string file;
+        std::optional<settings> snapshot;
+        clock::time_point due;
+        std::vector<std::promise<void>> waiting;
+        error_handler on_error;
+        // a save nobody waits for is part of it, so errors also go to on_error
+        bool unwanted;
+    };
+
+    flusher() : worker([this]{ run(); })
+    {
+        started = true;
+    }
+
+    void run()
+    {
+        std::unique_lock lock(mutex);
+        while(true)
+        {
+            if(jobs.empty())
+            {
+                if(stopping) return;
+                wake.wait(lock);
+                continue;
+            }
+
+            const auto next = std::min_element(jobs.begin(), jobs.end(), [](const job& lhs, const job& rhs){ return lhs.due < rhs.due; });
+            if(not stopping and clock::now() < next->due)
+            {
+                wake.wait_until(lock, next->due);
+                continue;
+            }
+
+            auto current = std::move(*next);
+            jobs.erase(next);
+            writing = current.file;
+            lock.unlock();
+
+            std::exception_ptr error;
+            try
+            {
+                if(current.snapshot) settings::write(current.file, *current.snapshot, true);
+            }
+            catch(...)
+            {
+                error = std::current_exception();
+            }
+
+            for(auto& waiting : current.waiting)
+            {
+                if(error) waiting.set_exception(error);
+                else waiting.set_value();
+            }
+            if(error and (current.waiting.empty() or current.unwanted)) report(current.file, current.on_error, error);
+            current.snapshot.reset();
+
+            lock.lock();
+            writing.clear();
+            written.notify_all();
+        }
     }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable written;
+    std::vector<job> jobs;
+    // the file the worker is writing without holding the lock
+    std::string writing;
+    bool stopping = false;
+    // started last, once everything it uses is constructed
+    std::thread worker;
+
+    inline static std::atomic<bool> started = false;
+};
+
+dot::settings::settings(const load_options& options)
+    : arena(options.arena ? std::make_unique<std::pmr::monotonic_buffer_resource>() : nullptr),
+      map(arena ? arena.get() : std::pmr::get_default_resource()),
+      async(options.async),
+      debounce(options.debounce),
+      on_error(options.on_error) {}
+
+dot::settings::settings(std::string file_path, load_options options) : settings(options)
+{
+    path = std::move(file_path);
+
+    // a save of the file that is still pending would otherwise be read back as the old contents, whatever the options of this one
+    flusher::wait_for(path);
+
+    if(options.cache) load_cached(path, options);
+    else load(path, options);
 }
 
-std::pair<bool, dot::inivariable::ini_tuple_element> dot::settings::parse_tuple_element(dot::iterator& begin, dot::iterator end, int line, char close)
+dot::settings::settings(settings&& other) noexcept : path(std::exchange(other.path, {})), arena(std::move(other.arena)), sources(std::move(other.sources)), map(std::move(other.map)), listeners(std::move(other.listeners)),
+    async(other.async), debounce(other.debounce), on_error(std::move(other.on_error)) {}
+
+dot::settings& dot::settings::operator=(settings&& other)
 {
-    begin = dot::iniparser::skip_whitespace(begin+1, end);
-    auto&& [next, variable] = parse_variable(begin, end, line);
-    begin = dot::iniparser::skip_whitespace(next, end);
+    if(this == &other) return *this;
+    // the map keeps its own resource, elements of another arena are moved over into it one by one
+    save();
+    path = std::exchange(other.path, {});
+    map = std::move(other.map);
+    sources = std::move(other.sources);
+    listeners = std::move(other.listeners);
+    async = other.async;
+    debounce = other.debounce;
+    on_error = std::move(other.on_error);
+    return *this;
+}
 
-    if     ( begin == end  ) error("end of file before tuple end", line);
-    else if(*begin == ','  ) return {false, std::forward<dot::inivariable::ini_tuple_element>(variable)};
-    else if(*begin == close) return {true , std::forward<dot::inivariable::ini_tuple_element>(variable)};
-    else error("could not find next , or closing brace after value", begin+1, line);
-    throw std::runtime_error("serious error");
+dot::settings dot::settings::load_many(const std::vector<std::string>& paths, unsigned threads, load_options options)
+{
+    std::vector<settings> parts(paths.size());
+    parallel_for(paths.size(), threads, [&](size_t i)
+    {
+        flusher::wait_for(paths[i]);
+        if(options.cache) parts[i].load_cached(paths[i], options);
+        else parts[i].load(paths[i], options);
+    });
+
+    settings result(options);
+    for(auto& part : parts) result.merge(std::move(part));
+    return result;
 }
 
-std::pair<dot::iterator, dot::inivariable::ini_tuple_element> dot::settings::parse_variable(dot::iterator begin, dot::iterator end, int line) noexcept
+dot::settings dot::settings::load_directory(const std::string& directory, unsigned threads, load_options options)
 {
-    constexpr const char* false_str = "false";
-    constexpr const char* true_str = "true";
+    std::vector<std::string> paths;
+    for(const auto& file : std::filesystem::directory_iterator(directory))
+    {
+        if(file.is_regular_file() and file.path().extension() == ".ini") paths.push_back(file.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return load_many(paths, threads, options);
+}
 
-    if(*begin == '"')
+void dot::settings::load(const std::string& file_path, load_options options)
+{
+    stats counted;
+    counted.files = 1;
+
+    if(options.mmap)
     {
-        auto result = dot::iniparser::find_string_end(begin, end);
-        return {result, std::string(begin+1, result-1)};
+        std::shared_ptr<mapped_file> file;
+        {
+            const stats::timer timer(counted.read_ns);
+            file = std::make_shared<mapped_file>(file_path);
+        }
+        counted.bytes = file->size();
+        stats::record(counted);
+
+        // lazy values still need the pages, so they are not released while parsing
+        if(options.threads == 1) parse(file->begin(), file->end(), options.lazy, options.lazy ? nullptr : file.get());
+        else parse_parallel(file->begin(), file->end(), options.threads, options.lazy);
+        if(options.lazy) sources.push_back(std::move(file));
+        return;
     }
-    else if(std::equal(begin, begin+5, false_str))
+
+    std::shared_ptr<const std::string> data;
     {
-        return {begin+5, false};
+        const stats::timer timer(counted.read_ns);
+        data = std::make_shared<const std::string>(iniparser::read_to_string(file_path));
+    }
+    counted.bytes = data->size();
+    stats::record(counted);
+
+    if(options.threads == 1) parse(data->data(), data->data() + data->size(), options.lazy);
+    else parse_parallel(data->data(), data->data() + data->size(), options.threads, options.lazy);
+    if(options.lazy) sources.push_back(std::move(data));
+}
+
+dot::settings dot::settings::copy() const
+{
+    settings result;
+    result.map = map;
+    return result;
+}
+
+size_t dot::settings::reload()
+{
+    if(path.empty()) return 0;
+
+    // the file on disk is behind while a save is pending, reading it would revert the saved values
+    flusher::wait_for(path);
+    settings fresh;
+    fresh.load(path, {});
+
+    // the whole difference is worked out before the tree changes, so a value that does not decode leaves nothing half applied.
+    // a lazy value in memory that does not decode differs from whatever the file holds now, so reloading replaces it.
+    const auto differs = [](const entry& current, const inivariable& value)
+    {
+        if(current.empty()) return true;
+        try { return not(current.value() == value); }
+        catch(const std::runtime_error&) { return true; }
+    };
+
+    struct update
+    {
+        std::string_view section;
+        std::string_view key;
+        entry* current;
+        inivariable* value;
+    };
+    std::vector<update> updates;
+    for(auto& [name, fresh_section] : fresh.map)
+    {
+        const auto section = find(name);
+        for(auto& [key, fresh_entry] : fresh_section)
+        {
+            const auto current = (section == nullptr) ? nullptr : section->find(key);
+            if(current != nullptr and (current->dirty() or not differs(*current, fresh_entry.variable))) continue;
+            updates.push_back(update{name, key, current, &fresh_entry.variable});
+        }
+    }
+
+    for(auto& [name, section] : map)
+    {
+        const auto fresh_section = fresh.find(name);
+        for(auto& [key, current] : section)
+        {
+            if(current.dirty() or current.empty() or (fresh_section != nullptr and fresh_section->contains(key))) continue;
+            updates.push_back(update{name, key, &current, nullptr});
+        }
     }
-    else if(std::equal(begin, begin+4, true_str))
+
+    // callbacks run once the tree is consistent again, as they may read other entries
+    std::vector<change> changes;
+    changes.reserve(updates.size());
+    for(const auto& [name, key, current, value] : updates)
     {
-        return {begin+4, true};
+        auto& target = (current != nullptr) ? *current : map.try_emplace(name).first->emplace(key);
+        target.variable = (value != nullptr) ? std::move(*value) : inivariable();
+        target.invalidate();
+        changes.push_back(change{name, key, &target});
     }
-    char* temp;
 
-    auto current = begin;
-    for(;current != end and dot::iniparser::is_number(*current); current++);
+    for(const auto& changed : changes) changed.value->notify();
+    notify(changes);
+    return changes.size();
+}
 
-    if(*current == '.')
+size_t dot::settings::commit(batch&& writes)
+{
+    // every target is resolved and decoded first, so a lazy value that does not parse throws before anything is applied
+    std::vector<entry*> targets;
+    targets.reserve(writes.writes.size());
+    for(const auto& write : writes.writes)
     {
-        double res = std::strtod(begin.base(), &temp);
-        if(temp == begin.base()) error("could not parse value", line);
-        return { static_cast<iterator>(temp), res };
+        auto& section = *map.try_emplace(write.section, write.section_hash).first;
+        auto& target = section.emplace(dot::key(write.key, write.key_hash));
+        target.decode();
+        targets.push_back(&target);
     }
-    else
+
+    std::vector<change> changes;
+    std::unordered_set<const entry*> seen;
+    for(size_t i = 0; i < targets.size(); i++)
     {
-        long res = std::strtol(begin.base(), &temp, 10);
-        if(temp == begin.base()) error("could not parse value", line);
-        return { static_cast<iterator>(temp), res };
+        auto& write = writes.writes[i];
+        auto& target = *targets[i];
+        if(target.variable == write.value) continue;
+
+        target.variable = std::move(write.value);
+        target.changed = true;
+        target.invalidate();
+        if(seen.insert(&target).second) changes.push_back(change{write.section, write.key, &target});
     }
+
+    for(const auto& changed : changes) changed.value->notify();
+    notify(changes);
+    if(async and not changes.empty()) save();
+    return changes.size();
 }
 
-dot::settings::~settings()
+void dot::settings::listen(std::function<void(const std::vector<change>&)> fn)
+{
+    listeners.push_back(std::move(fn));
+}
+
+void dot::settings::notify(const std::vector<change>& changes) const
+{
+    if(changes.empty()) return;
+    for(const auto& fn : listeners) fn(changes);
+}
+
+std::vector<const dot::entry*> dot::settings::find_all(const std::vector<std::pair<dot::key, dot::key>>& names) const
+{
+    std::vector<const entry*> result;
+    result.reserve(names.size());
+
+    const section* current = nullptr;
+    const dot::key* current_name = nullptr;
+    for(const auto& [section_name, key] : names)
+    {
+        if(current_name == nullptr or current_name->hash != section_name.hash or current_name->name != section_name.name)
+        {
+            current = find(section_name);
+            current_name = &section_name;
+        }
+        result.push_back((current == nullptr) ? nullptr : current->find(key));
+    }
+    return result;
+}
+
+void dot::settings::merge(settings&& other)
 {
-    if(path.empty()) return;
-    std::ofstream file(path);
-    file << *this;
+    for(auto& [name, other_section] : other.map)
+    {
+        auto& section = *map.try_emplace(name).first;
+        for(auto& [key, value] : other_section)
+        {
+            if(value.has_value()) section.emplace(key).take(std::move(value));
+        }
+    }
+    sources.insert(sources.end(), std::make_move_iterator(other.sources.begin()), std::make_move_iterator(other.sources.end()));
 }
 
-void dot::settings::error(const char* first, dot::iterator begin, int line)
+dot::iniparser::position dot::iniparser::tokenize(iterator begin, iterator end, handler& handler, int line, bool partial)
 {
-    error(first, begin, iniparser::skip_line(begin)-2, line);
+    auto current = begin;
+
+    while(current != end and not handler.stop)
+    {
+        // a newline inside a string does not end the line
+        auto line_end = scan::best().find_newline(current, end);
+        auto lines = 1;
+        if(*current != '#' and *current != ';')
+        {
+            for(auto quote = scan::best().find_quote(current, line_end); quote != line_end; quote = scan::best().find_quote(quote, line_end))
+            {
+                quote = find_string_end(quote, end);
+                if(quote <= line_end) continue;
+
+                lines += static_cast<int>(std::count(line_end, quote, '\n'));
+                line_end = scan::best().find_newline(quote, end);
+            }
+        }
+        if(partial and line_end == end) break;
+
+        if(*current == '[')
+        {
+            const auto next = find_token_end(++current, line_end);
+            if( next == line_end) error("line end before closing ]", line);
+            if(*next != ']') error("did not find closing ] after section name", line);
+
+            if(skip_whitespace(next+1, line_end) != line_end) error("symbols found after section name", next+1, line_end, line);
+            handler.on_section(std::string_view(current, static_cast<size_t>(next - current)), line);
+        }
+        else if(*current == '#' or *current == ';')
+        {
+        }
+        else if(is_whitespace(*current) or *current == '\n')
+        {
+            if(skip_whitespace(current, line_end) != line_end) error("please do not use whitespace before data", line);
+        }
+        else if(is_character(*current))
+        {
+            const auto token_end = find_token_end(current, line_end);
+
+            const auto var_begin = skip_whitespace(token_end, line_end);
+            if(var_begin == line_end or *var_begin != '=') error("could not find '='", line);
+
+            const auto value_begin = skip_whitespace(var_begin+1, line_end);
+            auto value_end = line_end;
+            while(value_end != value_begin and is_whitespace(*(value_end-1))) value_end--;
+
+            handler.on_variable(std::string_view(current, static_cast<size_t>(token_end - current)),
+                                std::string_view(value_begin, static_cast<size_t>(value_end - value_begin)), line);
+        }
+        else throw std::runtime_error(std::string("please do not use: \"") + *current + "\" as the start of a line");
+
+        current = (line_end == end) ? end : line_end + 1;
+        line += lines;
+    }
+    return {current, line};
 }
-void dot::settings::error(const char* first, dot::iterator begin, dot::iterator end, int line)
+
+void dot::iniparser::error(const char* first, dot::iterator begin, dot::iterator end, int line)
 {
     const std::string err = std::string(first) + std::string(": \"") + std::string(begin, end) + "\" on line: " + std::to_string(line);
     throw std::runtime_error(err);
 }
-void dot::settings::error(const char* first, int line)
+void dot::iniparser::error(const char* first, int line)
 {
     const std::string err = first + std::string(" on line: ") + std::to_string(line);
     throw std::runtime_error(err);
-}
\ No newline at end of file
+}
+
+//------------------------------------------------//
+
+std::vector<int> dot::settings::parse(iterator begin, iterator end, bool lazy, mapped_file* source, int line, iterator* stopped)
+{
+    struct builder final : iniparser::handler
+    {
+        builder(ordered_map<section>& sections, bool lazy_values, mapped_file* file) : map(sections), lazy(lazy_values), source(file) {}
+
+        void on_section(std::string_view name, int line) override
+        {
+            const stats::timer timer(counted.insert_ns);
+            const auto result = map.try_emplace(name);
+            if(not result.second) iniparser::error("duplicate section name", name.data(), name.data() + name.size(), line);
+            current = result.first;
+            lines.push_back(line);
+            counted.sections++;
+        }
+
+        void on_variable(std::string_view key, std::string_view value, int line) override
+        {
+            if(current == nullptr) iniparser::error("variable has no section", line);
+
+            // an empty value is an error right away, as the printer takes an empty undecoded text for a decoded value
+            const auto decode = [&]()
+            {
+                if(lazy and not value.empty() and value.size() <= std::numeric_limits<uint32_t>::max())
+                {
+                    return entry(inivariable::raw{value.data(), static_cast<uint32_t>(value.size()), line});
+                }
+                else return parse_value(value, line);
+            };
+
+            if constexpr(stats::enabled)
+            {
+                entry decoded;
+                {
+                    const stats::timer timer(counted.decode_ns);
+                    decoded.take(decode());
+                }
+                counted.variables++;
+                count_value(counted, decoded.variable);
+
+                const stats::timer timer(counted.insert_ns);
+                current->emplace(key).take(std::move(decoded));
+            }
+            else current->emplace(key).take(decode());
+
+            if(source != nullptr) source->release_before(value.data());
+        }
+
+        ordered_map<section>& map;
+        bool lazy;
+        mapped_file* source;
+        section* current = nullptr;
+        std::vector<int> lines;
+        stats counted;
+    };
+
+    builder builder(map, lazy, source);
+    {
+        const stats::timer timer(builder.counted.tokenize_ns);
+        const auto [position, last] = iniparser::tokenize(begin, end, builder, line, stopped != nullptr);
+        if(stopped != nullptr) *stopped = position;
+    }
+    // the handler runs inside the tokenizer, its time is taken out again
+    builder.counted.tokenize_ns -= builder.counted.decode_ns + builder.counted.insert_ns;
+    stats::record(builder.counted);
+    return std::move(builder.lines);
+}
+
+void dot::settings::parse_parallel(iterator begin, iterator end, unsigned threads, bool lazy)
+{
+    constexpr std::ptrdiff_t minimum_part = 1 << 18;
+
+    if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const auto parts = std::min<std::ptrdiff_t>(threads, (end - begin) / minimum_part);
+
+    // split right before lines that start with '[', so every part but the first starts with a section header
+    std::vector<iterator> bounds{begin};
+    for(std::ptrdiff_t i = 1; i < parts; i++)
+    {
+        auto newline = scan::best().find_newline(std::max(begin + (end - begin) * i / parts, bounds.back()), end);
+        while(newline != end and newline + 1 != end and *(newline + 1) != '[') newline = scan::best().find_newline(newline + 1, end);
+
+        if(newline == end or newline + 1 == end) break;
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(end);
+
+    const auto count = bounds.size() - 1;
+    if(count == 1)
+    {
+        parse(begin, end, lazy);
+        return;
+    }
+
+    // the first line of every part, so errors report the same line as a serial parse
+    std::vector<int> first_lines(count, 1);
+    parallel_for(count - 1, threads, [&](size_t i){ first_lines[i + 1] = static_cast<int>(std::count(bounds[i], bounds[i + 1], '\n')); });
+    for(size_t i = 1; i < count; i++) first_lines[i] += first_lines[i - 1];
+
+    // a newline followed by '[' inside a string looks like a split point as well. every part but the last ends in a newline,
+    // so the part in which such a string starts stops before its end, and the part after it may not parse at all.
+    // the file is parsed on one thread then, which also reports the errors of a file that does not parse.
+    std::vector<settings> results(count);
+    std::vector<std::vector<int>> section_lines(count);
+    std::vector<iterator> stopped(count, nullptr);
+    try
+    {
+        parallel_for(count, threads, [&](size_t i){ section_lines[i] = results[i].parse(bounds[i], bounds[i + 1], lazy, nullptr, first_lines[i], (i + 1 < count) ? &stopped[i] : nullptr); });
+    }
+    catch(const std::runtime_error&)
+    {
+        parse(begin, end, lazy);
+        return;
+    }
+    for(size_t i = 0; i + 1 < count; i++)
+    {
+        if(stopped[i] != bounds[i + 1])
+        {
+            parse(begin, end, lazy);
+            return;
+        }
+    }
+
+    for(size_t i = 0; i < count; i++)
+    {
+        size_t index = 0;
+        for(auto& [name, part] : results[i].map)
+        {
+            const auto [result, inserted] = map.try_emplace(name);
+            if(not inserted) iniparser::error("duplicate section name", name.data(), name.data() + name.size(), section_lines[i][index]);
+            *result = std::move(part);
+            index++;
+        }
+    }
+}
+
+dot::entry dot::settings::parse_value(std::string_view value, int line)
+{
+    const auto end = value.data() + value.size();
+    auto current = value.data();
+    if(current == end) iniparser::error("could not parse value", line);
+
+    entry result;
+    if(*current == '(' or *current == '[')
+    {
+        // elements are collected in a buffer that keeps its capacity, the entry gets a vector of exactly the right size
+        thread_local std::vector<inivariable::ini_tuple_element> tuple;
+        tuple.clear();
+        bool done = false;
+        bool is_tuple = *current == '(';
+
+        while(not done)
+        {
+            auto&& [new_done, var] = parse_tuple_element(current, end, line, (is_tuple) ? ')' : ']');
+            tuple.emplace_back(std::forward<inivariable::ini_tuple_element>(var));
+            done = new_done;
+        }
+        result.take(entry(std::vector<inivariable::ini_tuple_element>(std::make_move_iterator(tuple.begin()), std::make_move_iterator(tuple.end())), is_tuple));
+        current++;
+    }
+    else
+    {
+        auto&& [next, variable] = parse_variable(current, end, line);
+        result.take(entry(std::move(variable)));
+        current = next;
+    }
+    if(current != end) iniparser::error("line not empty after variable", line);
+    return result;
+}
+
+std::pair<bool, dot::inivariable::ini_tuple_element> dot::settings::parse_tuple_element(dot::iterator& begin, dot::iterator end, int line, char close)
+{
+    begin = dot::iniparser::skip_whitespace(begin+1, end);
+    auto&& [next, variable] = parse_variable(begin, end, line);
+    begin = dot::iniparser::skip_whitespace(next, end);
+
+    if     ( begin == end  ) iniparser::error("end of file before tuple end", line);
+    else if(*begin == ','  ) return {false, std::forward<dot::inivariable::ini_tuple_element>(variable)};
+    else if(*begin == close) return {true , std::forward<dot::inivariable::ini_tuple_element>(variable)};
+    else iniparser::error("could not find next , or closing brace after value", begin, end, line);
+    throw std::runtime_error("serious error");
+}
+
+std::pair<dot::iterator, dot::inivariable::ini_tuple_element> dot::settings::parse_variable(dot::iterator begin, dot::iterator end, int line)
+{
+    using namespace std::string_view_literals;
+    if(begin == end) iniparser::error("could not parse value", line);
+
+    const auto rest = std::string_view(begin, static_cast<size_t>(end - begin));
+    if(*begin == '"')
+    {
+        // without a closing quote the string runs to the end, which may be a quote that is escaped
+        const auto result = dot::iniparser::find_string_end(begin, end);
+        if(result - begin < 2 or *(result-1) != '"' or (result - begin > 2 and *(result-2) == '\\')) iniparser::error("string has no closing quote", begin, end, line);
+        return {result, std::string(begin+1, result-1)};
+    }
+    else if(rest.substr(0, 5) == "false"sv)
+    {
+        return {begin+5, false};
+    }
+    else if(rest.substr(0, 4) == "true"sv)
+    {
+        return {begin+4, true};
+    }
+    return parse_number(begin, end, line);
+}
+
+std::pair<dot::iterator, dot::inivariable::ini_tuple_element> dot::settings::parse_number(dot::iterator begin, dot::iterator end, int line)
+{
+    // std::from_chars ignores the locale and never reads past end, it only lacks the sign and the hex prefix
+    auto current = begin;
+    const bool negative = *current == '-';
+    if(*current == '-' or *current == '+') current++;
+
+    const bool hex = end - current > 2 and current[0] == '0' and (current[1] == 'x' or current[1] == 'X');
+    if(hex) current += 2;
+
+    const auto is_digit = [hex](char c){ return iniparser::is_number(c) or (hex and ((c >= 'a' and c <= 'f') or (c >= 'A' and c <= 'F'))); };
+    auto digits = current;
+    for(; digits != end and is_digit(*digits); digits++);
+
+    const bool floating = digits != end and (*digits == '.' or (hex ? (*digits == 'p' or *digits == 'P') : (*digits == 'e' or *digits == 'E')));
+    if(digits == current and not (floating and *digits == '.')) iniparser::error("could not parse value", begin, end, line);
+
+    if(floating)
+    {
+        double result;
+        const auto [next, error] = std::from_chars(current, end, result, hex ? std::chars_format::hex : std::chars_format::general);
+        if(error == std::errc::result_out_of_range) iniparser::error("number out of range", begin, next, line);
+        if(error != std::errc()) iniparser::error("could not parse value", begin, end, line);
+        return {next, negative ? -result : result};
+    }
+
+    // the magnitude is parsed unsigned, so the most negative long fits as well
+    unsigned long magnitude = 0;
+    const auto [next, error] = std::from_chars(current, end, magnitude, hex ? 16 : 10);
+    const auto limit = static_cast<unsigned long>(std::numeric_limits<long>::max()) + (negative ? 1 : 0);
+    if(error == std::errc::result_out_of_range or magnitude > limit) iniparser::error("integer out of range", begin, next, line);
+    if(error != std::errc()) iniparser::error("could not parse value", begin, end, line);
+
+    const long result = negative ? static_cast<long>(0 - magnitude) : static_cast<long>(magnitude);
+    return {next, result};
+}
+
+void dot::entry::decode(const inivariable::raw& text) const
+{
+    stats counted;
+    {
+        const stats::timer timer(counted.decode_ns);
+        variable = std::move(settings::parse_value(std::string_view(text.data, text.size), text.line).variable);
+    }
+    if constexpr(stats::enabled)
+    {
+        count_value(counted, variable);
+        stats::record(counted);
+    }
+}
+
+dot::settings::~settings()
+{
+    if(not async or path.empty() or not dirty())
+    {
+        save();
+        return;
+    }
+
+    // the tree itself is handed over, so the destructor does not wait for a copy or for the disk
+    const auto file = std::exchange(path, {});
+    auto handler = on_error;
+    flusher::instance().schedule(file, settings(std::move(*this)), debounce, std::move(handler), false);
+}
+
+std::future<void> dot::settings::flush()
+{
+    if(async and not path.empty())
+    {
+        auto pending = dirty() ? std::optional(snapshot()) : std::nullopt;
+        mark_saved();
+        return flusher::instance().schedule(path, std::move(pending), debounce, on_error, true);
+    }
+
+    std::promise<void> result;
+    try
+    {
+        if(not path.empty() and dirty())
+        {
+            write(path, *this, false);
+            mark_saved();
+        }
+        result.set_value();
+    }
+    catch(...)
+    {
+        result.set_exception(std::current_exception());
+    }
+    return result.get_future();
+}
+
+void dot::settings::save()
+{
+    if(path.empty() or not dirty()) return;
+
+    if(async)
+    {
+        flusher::instance().schedule(path, snapshot(), debounce, on_error, false);
+        mark_saved();
+        return;
+    }
+
+    try
+    {
+        write(path, *this, false);
+        mark_saved();
+    }
+    catch(...)
+    {
+        report(path, on_error, std::current_exception());
+    }
+}
+
+void dot::settings::write(const std::string& file, const settings& snapshot, bool durable)
+{
+    std::string output;
+    try
+    {
+        output = snapshot.patch(iniparser::read_to_string(file));
+    }
+    catch(const std::runtime_error&)
+    {
+        // the file is gone or no longer parses, so there is nothing to keep and it is written from scratch
+        inibuffer buffer;
+        buffer << snapshot;
+        output = buffer.release();
+    }
+
+    // a symlink is written through, the file it points to is the one that is replaced
+    std::error_code resolved;
+    auto target = std::filesystem::weakly_canonical(file, resolved).string();
+    if(resolved) target = file;
+
+    // written next to the file and renamed over it, so a crash never leaves half a file behind
+    // with the owner and permissions of the file it replaces
+    struct stat info{};
+    const auto exists = stat(target.c_str(), &info) == 0;
+    const auto mode = exists ? (info.st_mode & 07777) : 0644;
+    // the temporary file has a unique name, so two saves of the same file never write into each other's
+    const auto temp = write_temp(target, output, mode, durable);
+    if(temp.empty()) throw std::runtime_error("could not write file: " + target + ": " + std::strerror(errno));
+
+    if(exists)
+    {
+        // only root can hand a file to another user, anyone else keeps the group when they are in it.
+        // when neither is allowed the file is still saved, owned by the writer like a file that is new
+        [[maybe_unused]] const auto owned = chown(temp.c_str(), info.st_uid, info.st_gid) == 0 or chown(temp.c_str(), static_cast<uid_t>(-1), info.st_gid) == 0;
+        // chown clears the set-id bits
+        chmod(temp.c_str(), mode);
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp, target, error);
+    if(error)
+    {
+        unlink(temp.c_str());
+        throw std::runtime_error("could not rename " + temp + " to " + target + ": " + error.message());
+    }
+    if(durable) sync_directory(target);
+}
+
+dot::settings dot::settings::snapshot() const
+{
+    auto result = copy();
+    result.take_dirty(*this);
+    return result;
+}
+
+void dot::settings::take_dirty(const settings& other)
+{
+    for(const auto& [name, other_section] : other.map)
+    {
+        for(const auto& [key, other_entry] : other_section)
+        {
+            if(not other_entry.dirty()) continue;
+            // an erased entry stays behind as an empty one, so the copy has every dirty entry
+            if(auto section = map.find(name))
+            {
+                if(auto found = section->find(key)) found->changed = true;
+            }
+        }
+    }
+}
+
+void dot::settings::mark_saved() noexcept
+{
+    for(auto& [name, section] : map)
+    {
+        for(auto& [key, entry] : section) entry.changed = false;
+    }
+}
+
+void dot::settings::report(const std::string& file, const error_handler& on_error, std::exception_ptr error)
+{
+    if(on_error)
+    {
+        on_error(file, std::move(error));
+        return;
+    }
+
+    try
+    {
+        std::rethrow_exception(error);
+    }
+    catch(const std::exception& exception)
+    {
+        std::cerr << "could not save " << file << ": " << exception.what() << '\n';
+    }
+    catch(...)
+    {
+        std::cerr << "could not save " << file << '\n';
+    }
+}
+
+bool dot::settings::dirty() const noexcept
+{
+    for(const auto& [name, section] : map)
+    {
+        for(const auto& [key, entry] : section)
+        {
+            if(entry.dirty()) return true;
+        }
+    }
+    return false;
+}
+
+std::string dot::settings::patch(const std::string& original) const
+{
+    // the ranges of the dirty variables in the file on disk, as offsets.
+    // only dirty sections are looked at, every other line is skipped without a lookup.
+    struct variable_range
+    {
+        size_t line_begin;
+        size_t value_begin;
+        size_t value_end;
+        size_t line_end;
+    };
+    struct section_range
+    {
+        size_t insert = std::string::npos; // after the last line of the section that is not a comment, npos when it is not in the file
+        // every line of a key, which can be in a section more than once
+        std::unordered_map<const entry*, std::vector<variable_range>> variables;
+    };
+
+    struct locator final : iniparser::handler
+    {
+        explicit locator(const std::string& contents) : data(contents) {}
+
+        void on_section(std::string_view name, int) override
+        {
+            const auto found = map->find(name);
+            const auto range = (found == nullptr) ? sections.end() : sections.find(found);
+            current = (range == sections.end()) ? nullptr : &*range;
+            if(current != nullptr) current->second.insert = line_end(name.data() + name.size());
+        }
+
+        void on_variable(std::string_view key, std::string_view value, int) override
+        {
+            if(current == nullptr) return;
+            const auto value_end = value.data() + value.size();
+            current->second.insert = line_end(value_end);
+
+            const auto found = current->first->find(key);
+            if(found != nullptr and found->dirty()) current->second.variables[found].push_back({offset(key.data()), offset(value.data()), offset(value_end), current->second.insert});
+        }
+
+        size_t offset(iterator position) const noexcept { return static_cast<size_t>(position - data.data()); }
+        size_t line_end(iterator position) const noexcept { return offset(iniparser::skip_line(position, data.data() + data.size())); }
+
+        const std::string& data;
+        const ordered_map<section>* map = nullptr;
+        std::unordered_map<const section*, section_range> sections;
+        std::pair<const section* const, section_range>* current = nullptr;
+    };
+
+    locator located(original);
+    located.map = &map;
+    for(const auto& [name, section] : map)
+    {
+        if(std::any_of(section.begin(), section.end(), [](const auto& data){ return data.second.dirty(); })) located.sections[&section];
+    }
+    iniparser::tokenize(original.data(), original.data() + original.size(), located);
+
+    struct edit
+    {
+        size_t begin;
+        size_t end;
+        std::string text;
+    };
+    std::vector<edit> edits;
+    std::string appended;
+
+    // lines that are added end like the first line of the file
+    const auto first_newline = original.find('\n');
+    const std::string eol = (first_newline != std::string::npos and first_newline > 0 and original[first_newline - 1] == '\r') ? "\r\n" : "\n";
+
+    const auto print = [](const auto& value)
+    {
+        inibuffer buffer;
+        iniprinter::print(buffer, value);
+        return buffer.release();
+    };
+    const auto print_section = [&](std::string_view name, const section& section)
+    {
+        if(std::none_of(section.begin(), section.end(), [](const auto& data){ return data.second.has_value(); })) return std::string();
+
+        auto text = '[' + std::string(name) + ']' + eol;
+        for(const auto& [key, entry] : section)
+        {
+            if(entry.has_value()) text += std::string(key) + " = " + print(entry) + eol;
+        }
+        return text + eol;
+    };
+
+    for(const auto& [name, section] : map)
+    {
+        const auto range = located.sections.find(&section);
+        if(range == located.sections.end()) continue;
+
+        const auto& [insert, variables] = range->second;
+        if(insert == std::string::npos)
+        {
+            appended += print_section(name, section);
+            continue;
+        }
+
+        for(const auto& [key, entry] : section)
+        {
+            if(not entry.dirty()) continue;
+
+            const auto variable = variables.find(&entry);
+            if(variable == variables.end())
+            {
+                if(entry.has_value()) edits.push_back({insert, insert, std::string(key) + " = " + print(entry) + eol});
+                continue;
+            }
+
+            // the last line of a key is the one that is read back, the ones before it are removed so they do not come back
+            const auto& ranges = variable->second;
+            for(size_t i = 0; i + 1 < ranges.size(); i++) edits.push_back({ranges[i].line_begin, ranges[i].line_end, {}});
+            if(entry.empty()) edits.push_back({ranges.back().line_begin, ranges.back().line_end, {}});
+            else edits.push_back({ranges.back().value_begin, ranges.back().value_end, print(entry)});
+        }
+    }
+
+    // insertions at the same place keep the order of the keys
+    std::stable_sort(edits.begin(), edits.end(), [](const auto& lhs, const auto& rhs){ return lhs.begin < rhs.begin; });
+
+    std::string result;
+    result.reserve(original.size() + appended.size());
+    size_t position = 0;
+    for(const auto& [begin, end, text] : edits)
+    {
+        result.append(original, position, begin - position);
+        // the last line of the file may not end in a newline
+        if(begin == original.size() and not text.empty() and not result.empty() and result.back() != '\n') result += eol;
+        result += text;
+        position = end;
+    }
+    result.append(original, position);
+
+    if(not appended.empty())
+    {
+        // a blank line between the sections, like the printer leaves
+        const auto blank = eol + eol;
+        if(not result.empty() and result.back() != '\n') result += eol;
+        if(not result.empty() and (result.size() < blank.size() or result.compare(result.size() - blank.size(), blank.size(), blank) != 0)) result += eol;
+        result += appended;
+    }
+    return result;
+}
+
+//------------------------------------------------//
+
+namespace
+{
+    // a snapshot is a header followed by the section index, the key index, the value arrays and the string table.
+    // every record is a multiple of 8 bytes, so a mapping of the file can be read in place.
+    constexpr char snapshot_magic[4] = {'D', 'I', 'N', 'I'};
+    constexpr uint32_t snapshot_version = 1;
+    constexpr uint32_t snapshot_byte_order = 0x01020304;
+
+    struct snapshot_header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t reserved;
+        // of everything after the header
+        uint64_t checksum;
+        uint64_t size;
+
+        uint64_t source_size;
+        int64_t source_mtime;
+        uint64_t source_hash;
+
+        uint64_t sections;
+        uint64_t keys;
+        uint64_t data_offset;
+        uint64_t data_size;
+        uint64_t strings_offset;
+        uint64_t strings_size;
+    };
+
+    // an offset and size in the string table, which is limited to 4 GB
+    struct string_ref
+    {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    struct section_record
+    {
+        uint64_t hash;
+        string_ref name;
+        uint32_t first_key;
+        uint32_t keys;
+    };
+
+    // type is the index of the alternative in inivariable::ini_element.
+    // bool, double and long are stored in data itself, a string is an offset in the string table with count as its size,
+    // lists and tuples are an offset in the value arrays with count elements.
+    struct key_record
+    {
+        uint64_t hash;
+        string_ref name;
+        uint32_t type;
+        uint32_t count;
+        uint64_t data;
+    };
+
+    // type is the index of the alternative in inivariable::ini_tuple_element, a string keeps its size in size
+    struct tuple_record
+    {
+        uint32_t type;
+        uint32_t size;
+        uint64_t data;
+    };
+
+    // fnv-1a over 8 byte words with the high half folded back in, fast enough to check a snapshot on every load
+    uint64_t checksum(const char* data, size_t size) noexcept
+    {
+        uint64_t result = 14695981039346656037ull;
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            result = (result ^ word) * 1099511628211ull;
+            result ^= result >> 32;
+        }
+        for(; i < size; i++) result = (result ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+        return result;
+    }
+
+    template<typename T>
+    uint64_t bits(T value) noexcept
+    {
+        uint64_t result = 0;
+        std::memcpy(&result, &value, sizeof(value));
+        return result;
+    }
+
+    template<typename T>
+    T from_bits(uint64_t value) noexcept
+    {
+        T result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+
+    class snapshot_writer
+    {
+    public:
+        string_ref string(std::string_view text)
+        {
+            const auto offset = strings.size();
+            if(text.size() > std::numeric_limits<uint32_t>::max() - offset) throw std::length_error("strings too big for a binary snapshot");
+            strings.append(text);
+            return {static_cast<uint32_t>(offset), static_cast<uint32_t>(text.size())};
+        }
+
+        // appends the array to the value arrays, padded to 8 bytes, and returns its offset
+        template<typename T>
+        uint64_t array(const T* values, size_t count)
+        {
+            const auto offset = data.size();
+            data.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+            data.resize((data.size() + 7) / 8 * 8, '\0');
+            return offset;
+        }
+
+        static uint32_t count(size_t size)
+        {
+            if(size > std::numeric_limits<uint32_t>::max()) throw std::length_error("list too long for a binary snapshot");
+            return static_cast<uint32_t>(size);
+        }
+
+        void value(key_record& record, const dot::inivariable& variable)
+        {
+            record.type = static_cast<uint32_t>(variable.index());
+            variable.visit([&](const auto& value){ store(record, value); });
+        }
+
+        std::vector<section_record> sections;
+        std::vector<key_record> keys;
+        std::string data;
+        std::string strings;
+
+    private:
+        void store(key_record&, const std::monostate&) {}
+        void store(key_record&, const dot::inivariable::raw&) {}
+        void store(key_record& record, bool value) { record.data = value; }
+        void store(key_record& record, double value) { record.data = bits(value); }
+        void store(key_record& record, long value) { record.data = bits(value); }
+        void store(key_record& record, const std::string& value)
+        {
+            const auto ref = string(value);
+            record.data = ref.offset;
+            record.count = ref.size;
+        }
+        void store(key_record& record, const dot::boxed<std::vector<bool>>& value)
+        {
+            const std::vector<uint8_t> bytes(value.get().begin(), value.get().end());
+            record.count = count(bytes.size());
+            record.data = array(bytes.data(), bytes.size());
+        }
+        template<typename T>
+        void store(key_record& record, const std::vector<T>& value)
+        {
+            record.count = count(value.size());
+            if constexpr(std::is_same_v<T, std::string>)
+            {
+                std::vector<string_ref> refs;
+                refs.reserve(value.size());
+                for(const auto& elem : value) refs.push_back(string(elem));
+                record.data = array(refs.data(), refs.size());
+            }
+            else if constexpr(std::is_same_v<T, dot::inivariable::ini_tuple_element>)
+            {
+                std::vector<tuple_record> records;
+                records.reserve(value.size());
+                for(const auto& elem : value)
+                {
+                    tuple_record tuple{static_cast<uint32_t>(elem.index()), 0, 0};
+                    if     (const auto boolean = std::get_if<bool>(&elem)) tuple.data = *boolean;
+                    else if(const auto number = std::get_if<double>(&elem)) tuple.data = bits(*number);
+                    else if(const auto integer = std::get_if<long>(&elem)) tuple.data = bits(*integer);
+                    else
+                    {
+                        const auto ref = string(std::get<std::string>(elem));
+                        tuple.data = ref.offset;
+                        tuple.size = ref.size;
+                    }
+                    records.push_back(tuple);
+                }
+                record.data = array(records.data(), records.size());
+            }
+            else record.data = array(value.data(), value.size());
+        }
+    };
+
+    std::runtime_error invalid(const char* reason)
+    {
+        return std::runtime_error(std::string("invalid binary snapshot: ") + reason);
+    }
+
+    // the header of a snapshot that is complete and not corrupt, the records are checked while they are read
+    const snapshot_header& check_snapshot(const dot::mapped_file& file)
+    {
+        if(file.size() < sizeof(snapshot_header)) throw invalid("truncated header");
+        const auto& header = *reinterpret_cast<const snapshot_header*>(file.begin());
+
+        if(std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) != 0) throw invalid("not a snapshot");
+        if(header.version != snapshot_version) throw invalid("unsupported version");
+        if(header.byte_order != snapshot_byte_order) throw invalid("written with another byte order");
+        if(header.size != file.size()) throw invalid("truncated file");
+        if(header.checksum != checksum(file.begin() + sizeof(header), file.size() - sizeof(header))) throw invalid("checksum mismatch");
+
+        const auto size = file.size();
+        if(header.sections > size / sizeof(section_record) or header.keys > size / sizeof(key_record)) throw invalid("index out of bounds");
+        const auto index_end = sizeof(header) + header.sections * sizeof(section_record) + header.keys * sizeof(key_record);
+        if(index_end > size or header.data_offset != index_end or header.data_offset % 8 != 0 or header.data_size > size - index_end) throw invalid("index out of bounds");
+        if(header.strings_offset != header.data_offset + header.data_size or header.strings_size != size - header.strings_offset) throw invalid("strings out of bounds");
+        return header;
+    }
+}
+
+void dot::settings::save_binary(const std::string& file) const
+{
+    write_snapshot(file, {});
+}
+
+dot::settings dot::settings::load_binary(const std::string& file)
+{
+    settings result;
+    result.read_snapshot(mapped_file(file));
+    return result;
+}
+
+void dot::settings::load_cached(const std::string& file, load_options options)
+{
+    struct stat info{};
+    if(stat(file.c_str(), &info) != 0) throw std::runtime_error("could not open file: " + file);
+    source_stamp source{static_cast<uint64_t>(info.st_size), info.st_mtim.tv_sec * 1000000000l + info.st_mtim.tv_nsec, 0};
+
+    // the snapshot is only a cache, one that is missing, stale or corrupt is made again from the text.
+    // a touched file with the same contents is recognised by its hash and only gets a new stamp.
+    const auto cache = file + ".cache";
+    std::string text;
+    bool hashed = false;
+    try
+    {
+        const mapped_file snapshot(cache);
+        if(snapshot.size() >= sizeof(snapshot_header))
+        {
+            const auto& header = *reinterpret_cast<const snapshot_header*>(snapshot.begin());
+            bool fresh = header.source_size == source.size and header.source_mtime == source.mtime;
+            if(not fresh and header.source_size == source.size)
+            {
+                text = iniparser::read_to_string(file);
+                source.hash = checksum(text.data(), text.size());
+                hashed = true;
+                fresh = header.source_hash == source.hash;
+            }
+            if(fresh)
+            {
+                read_snapshot(snapshot);
+                if(hashed) write_snapshot(cache, source);
+                return;
+            }
+        }
+    }
+    catch(const std::runtime_error&)
+    {
+        map.clear();
+    }
+
+    if(not hashed)
+    {
+        text = iniparser::read_to_string(file);
+        source.hash = checksum(text.data(), text.size());
+    }
+    if(options.threads == 1) parse(text.data(), text.data() + text.size(), false);
+    else parse_parallel(text.data(), text.data() + text.size(), options.threads, false);
+
+    // a directory that cannot be written to only loses the cache
+    try { write_snapshot(cache, source); }
+    catch(const std::runtime_error&) {}
+}
+
+void dot::settings::write_snapshot(const std::string& file, const source_stamp& source) const
+{
+    snapshot_writer writer;
+    for(const auto& [name, section] : map)
+    {
+        section_record record{hash(name), writer.string(name), snapshot_writer::count(writer.keys.size()), 0};
+        for(const auto& [key, entry] : section)
+        {
+            if(entry.empty()) continue;
+            entry.decode();
+
+            key_record value{hash(key), writer.string(key), 0, 0, 0};
+            writer.value(value, entry.variable);
+            writer.keys.push_back(value);
+        }
+        record.keys = static_cast<uint32_t>(writer.keys.size() - record.first_key);
+        writer.sections.push_back(record);
+    }
+
+    snapshot_header header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.byte_order = snapshot_byte_order;
+    header.source_size = source.size;
+    header.source_mtime = source.mtime;
+    header.source_hash = source.hash;
+    header.sections = writer.sections.size();
+    header.keys = writer.keys.size();
+    header.data_offset = sizeof(header) + writer.sections.size() * sizeof(section_record) + writer.keys.size() * sizeof(key_record);
+    header.data_size = writer.data.size();
+    header.strings_offset = header.data_offset + header.data_size;
+    header.strings_size = writer.strings.size();
+    header.size = header.strings_offset + header.strings_size;
+
+    std::string output(sizeof(header), '\0');
+    output.reserve(header.size);
+    output.append(reinterpret_cast<const char*>(writer.sections.data()), writer.sections.size() * sizeof(section_record));
+    output.append(reinterpret_cast<const char*>(writer.keys.data()), writer.keys.size() * sizeof(key_record));
+    output.append(writer.data);
+    output.append(writer.strings);
+
+    header.checksum = checksum(output.data() + sizeof(header), output.size() - sizeof(header));
+    std::memcpy(output.data(), &header, sizeof(header));
+
+    const auto temp = write_temp(file, output, 0644);
+    if(temp.empty()) throw std::runtime_error("could not write file: " + file);
+
+    std::error_code error;
+    std::filesystem::rename(temp, file, error);
+    if(error)
+    {
+        unlink(temp.c_str());
+        throw std::runtime_error("could not rename " + temp + " to " + file + ": " + error.message());
+    }
+}
+
+void dot::settings::read_snapshot(const mapped_file& snapshot)
+{
+    stats counted;
+    counted.files = 1;
+    counted.bytes = snapshot.size();
+
+    const auto& header = [&]() -> const snapshot_header&
+    {
+        const stats::timer timer(counted.read_ns);
+        return check_snapshot(snapshot);
+    }();
+    const auto sections = reinterpret_cast<const section_record*>(snapshot.begin() + sizeof(header));
+    const auto keys = reinterpret_cast<const key_record*>(sections + header.sections);
+    const auto data = snapshot.begin() + header.data_offset;
+    const auto strings = snapshot.begin() + header.strings_offset;
+
+    const auto string = [&](uint64_t offset, uint64_t size)
+    {
+        if(offset > header.strings_size or size > header.strings_size - offset) throw invalid("string out of bounds");
+        return std::string_view(strings + offset, size);
+    };
+    const auto array = [&](const key_record& record, size_t element)
+    {
+        if(record.data % 8 != 0 or record.data > header.data_size or record.count > (header.data_size - record.data) / element) throw invalid("value out of bounds");
+        return data + record.data;
+    };
+
+    {
+        const stats::timer timer(counted.insert_ns);
+        // the counts are known up front, so the indices are sized once
+        map.reserve(header.sections);
+        for(size_t i = 0; i < header.sections; i++)
+        {
+            const auto& record = sections[i];
+            if(record.first_key > header.keys or record.keys > header.keys - record.first_key) throw invalid("key out of bounds");
+
+            auto& target = *map.try_emplace(string(record.name.offset, record.name.size), record.hash).first;
+            target.reserve(record.keys);
+            for(size_t k = record.first_key; k < size_t(record.first_key) + record.keys; k++)
+            {
+                const auto& key = keys[k];
+                auto& variable = target.emplace(dot::key(string(key.name.offset, key.name.size), key.hash)).variable;
+
+                switch(key.type)
+                {
+                    case 1: variable.emplace<bool>(key.data != 0); break;
+                    case 2: variable.emplace<double>(from_bits<double>(key.data)); break;
+                    case 3: variable.emplace<long>(from_bits<long>(key.data)); break;
+                    case 4: variable.emplace<std::string>(string(key.data, key.count)); break;
+                    case 5:
+                    {
+                        const auto values = array(key, sizeof(uint8_t));
+                        variable.emplace<boxed<std::vector<bool>>>().get().assign(values, values + key.count);
+                        break;
+                    }
+                    case 6:
+                    {
+                        const auto values = reinterpret_cast<const double*>(array(key, sizeof(double)));
+                        variable.emplace<std::vector<double>>(values, values + key.count);
+                        break;
+                    }
+                    case 7:
+                    {
+                        const auto values = reinterpret_cast<const long*>(array(key, sizeof(long)));
+                        variable.emplace<std::vector<long>>(values, values + key.count);
+                        break;
+                    }
+                    case 8:
+                    {
+                        const auto refs = reinterpret_cast<const string_ref*>(array(key, sizeof(string_ref)));
+                        auto& values = variable.emplace<std::vector<std::string>>();
+                        values.reserve(key.count);
+                        for(size_t j = 0; j < key.count; j++) values.emplace_back(string(refs[j].offset, refs[j].size));
+                        break;
+                    }
+                    case 9:
+                    {
+                        const auto records = reinterpret_cast<const tuple_record*>(array(key, sizeof(tuple_record)));
+                        auto& values = variable.emplace<std::vector<inivariable::ini_tuple_element>>();
+                        values.reserve(key.count);
+                        for(size_t j = 0; j < key.count; j++)
+                        {
+                            const auto& elem = records[j];
+                            if     (elem.type == 0) values.emplace_back(elem.data != 0);
+                            else if(elem.type == 1) values.emplace_back(from_bits<double>(elem.data));
+                            else if(elem.type == 2) values.emplace_back(from_bits<long>(elem.data));
+                            else if(elem.type == 3) values.emplace_back(std::string(string(elem.data, elem.size)));
+                            else throw invalid("unknown tuple element type");
+                        }
+                        break;
+                    }
+                    default: throw invalid("unknown value type");
+                }
+                if constexpr(stats::enabled) count_value(counted, variable);
+            }
+        }
+    }
+
+    counted.sections = header.sections;
+    counted.variables = header.keys;
+    stats::record(counted);
+}
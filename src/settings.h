@@ -14,13 +14,25 @@
 #include <memory>
 #include <variant>
 #include <vector>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <atomic>
 #include <algorithm>
 #include <fstream>
 #include <functional>
+#include <memory_resource>
+#include <cstdint>
+#include <typeindex>
+#include <utility>
+#include <chrono>
+#include <future>
+
+#include "stats.h"
 
 namespace dot
 {
-    using iterator = std::string::const_iterator;
+    using iterator = const char*;
 
     template<typename T>
     struct false_type : std::false_type {};
@@ -60,6 +72,71 @@ namespace dot
     using type_converter_t = typename type_converter<type_index<T>()>::type;
 
 
+    // gets the file a save failed for and the error it threw
+    using error_handler = std::function<void(const std::string& file, std::exception_ptr error)>;
+
+    struct load_options
+    {
+        // parse straight from a read only mapping of the file instead of copying it into a string first
+        bool mmap = false;
+
+        // keys and the lookup index live in one monotonic arena that is released at once with the settings.
+        // values stay on the heap as they are handed out as std::string and std::vector.
+        bool arena = false;
+
+        // big files are split before lines that start with '[' and the parts are parsed on this many threads,
+        // 0 uses one thread per core. a split that falls inside a string, after a newline in it, parses the file on one thread.
+        unsigned threads = 1;
+
+        // values are only checked and decoded on their first access, until then an entry points into the file contents,
+        // which the settings keeps alive. syntax errors in a value are thrown by that first access instead of the constructor.
+        bool lazy = false;
+
+        // keeps a binary snapshot next to the file, as file + ".cache", and loads that instead of parsing
+        // while the file has the same size and modification time, or the same contents. see settings::save_binary.
+        bool cache = false;
+
+        // the file is written by a background thread instead of by the destructor or the caller of flush, see settings::flush.
+        // the contents go to a temporary file that is synced to disk before it is renamed over the file.
+        bool async = false;
+
+        // with async, a write waits until the file was not asked to be saved for this long, so a burst of saves writes it once
+        std::chrono::milliseconds debounce{10};
+
+        // called with the error of a save nobody waits for, like the one of the destructor. by default it is printed to std::cerr.
+        error_handler on_error;
+    };
+
+    // read only private mapping of a whole file, unmapped on destruction.
+    // pages that were parsed already can be handed back to the kernel with release_before.
+    class mapped_file
+    {
+    public:
+        explicit mapped_file(const std::string& path);
+        ~mapped_file();
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        [[nodiscard]] iterator begin() const noexcept { return data; }
+        [[nodiscard]] iterator end() const noexcept { return data + length; }
+        [[nodiscard]] size_t size() const noexcept { return length; }
+
+        void release_before(iterator position) noexcept
+        {
+            if(position - released >= release_step) release(position);
+        }
+
+    private:
+        void release(iterator position) noexcept;
+
+        static constexpr std::ptrdiff_t release_step = 1 << 22;
+
+        const char* data = nullptr;
+        size_t length = 0;
+        iterator released = nullptr;
+    };
+
     struct iniparser
     {
         [[nodiscard]] static std::string read_to_string(const std::string& path);
@@ -76,18 +153,102 @@ namespace dot
 
         [[nodiscard]] static iterator skip_line(iterator begin, iterator end) noexcept;
 
-        [[nodiscard]] static iterator skip_line(iterator begin) noexcept;
-
         [[nodiscard]] static std::pair<iterator, bool> skip_empty_line(iterator begin, iterator end) noexcept;
 
         [[nodiscard]] static iterator find_string_end(iterator begin, iterator end) noexcept;
+
+        // receives the sections and the raw text of the variables of a buffer, in order
+        class handler
+        {
+        public:
+            virtual ~handler() = default;
+            virtual void on_section(std::string_view name, int line) = 0;
+            virtual void on_variable(std::string_view key, std::string_view value, int line) = 0;
+
+            // set by the handler to end tokenize after the current line
+            bool stop = false;
+        };
+
+        struct position
+        {
+            iterator current;
+            int line;
+        };
+
+        // calls the handler for every line in [begin, end), counting lines from the given one.
+        // when partial is set the last line is only handled if it ends with a newline, the returned position is where parsing stopped.
+        static position tokenize(iterator begin, iterator end, handler& handler, int line = 1, bool partial = false);
+
+        [[noreturn]] static void error(const char* first, iterator begin, iterator end, int line);
+        [[noreturn]] static void error(const char* first, int line);
+    };
+
+    // a value behind a pointer that still copies like a value.
+    // std::vector<bool> is bigger than every other alternative of an inivariable, boxing it keeps the variant small.
+    template<typename T>
+    class boxed
+    {
+    public:
+        boxed() : value(std::make_unique<T>()) {}
+        boxed(T&& other) : value(std::make_unique<T>(std::move(other))) {}
+        boxed(const T& other) : value(std::make_unique<T>(other)) {}
+
+        boxed(const boxed& other) : value(std::make_unique<T>(*other.value)) {}
+        boxed(boxed&& other) noexcept = default;
+
+        boxed& operator=(const boxed& other)
+        {
+            value = std::make_unique<T>(*other.value);
+            return *this;
+        }
+        boxed& operator=(boxed&& other) noexcept = default;
+
+        [[nodiscard]] T& get() noexcept { return *value; }
+        [[nodiscard]] const T& get() const noexcept { return *value; }
+
+        [[nodiscard]] friend bool operator==(const boxed& lhs, const boxed& rhs) { return lhs.get() == rhs.get(); }
+
+    private:
+        std::unique_ptr<T> value;
+    };
+
+    // a read only view of a stored list, std::span is not in c++17
+    template<typename T>
+    class array_view
+    {
+    public:
+        constexpr array_view(const T* first, size_t count) noexcept : items(first), length(count) {}
+
+        [[nodiscard]] constexpr const T* data() const noexcept { return items; }
+        [[nodiscard]] constexpr size_t size() const noexcept { return length; }
+        [[nodiscard]] constexpr bool empty() const noexcept { return length == 0; }
+
+        [[nodiscard]] constexpr const T* begin() const noexcept { return items; }
+        [[nodiscard]] constexpr const T* end() const noexcept { return items + length; }
+
+        [[nodiscard]] constexpr const T& operator[](size_t index) const noexcept { return items[index]; }
+
+    private:
+        const T* items;
+        size_t length;
     };
 
     class inivariable
     {
     public:
         using ini_tuple_element = std::variant<bool, double, long, std::string>;
-        using ini_element = std::variant<std::monostate, bool, double, long, std::string, std::vector<bool>, std::vector<double>, std::vector<long>,  std::vector<std::string>, std::vector<ini_tuple_element>>;
+        // the text of a lazily loaded value that was not decoded yet
+        struct raw
+        {
+            const char* data;
+            uint32_t size;
+            int line;
+
+            // the same text, two values are only compared after decoding
+            [[nodiscard]] friend bool operator==(const raw& lhs, const raw& rhs) noexcept { return std::string_view(lhs.data, lhs.size) == std::string_view(rhs.data, rhs.size); }
+        };
+
+        using ini_element = std::variant<std::monostate, bool, double, long, std::string, boxed<std::vector<bool>>, std::vector<double>, std::vector<long>,  std::vector<std::string>, std::vector<ini_tuple_element>, raw>;
 
         explicit inivariable() = default;
 
@@ -98,16 +259,18 @@ namespace dot
 
             if constexpr (sizeof...(Types) == 1)
             {
-                auto first = std::get<0>(std::tuple(types...));
-                if constexpr      (is_convertible_type_v<Type>) entry = static_cast<type_converter_t<Type>>(first);
-                else if constexpr (std::is_same_v<Type, ini_tuple_element>) find_index(std::forward<ini_tuple_element>(first), entry);
+                auto&& first = std::get<0>(std::forward_as_tuple(std::forward<Types>(types)...));
+                if constexpr      (is_convertible_type_v<Type>) entry = static_cast<type_converter_t<Type>>(std::forward<decltype(first)>(first));
+                else if constexpr (std::is_same_v<Type, ini_tuple_element>) find_index(ini_tuple_element(std::forward<decltype(first)>(first)), entry);
+                else if constexpr (std::is_same_v<Type, raw>) entry = first;
                 else static_assert(false_type<Type>::value, "type for variable not supported");
             }
             else if constexpr (sizeof...(Types) == 2 and std::is_same_v<Type, std::vector<ini_tuple_element>>)
             {
-                auto first = std::get<0>(std::tuple(types...));
-                if(std::get<1>(std::tuple(types...))) entry.emplace<std::vector<ini_tuple_element>>(first);
-                else check_and_convert_vector(std::forward<std::vector<ini_tuple_element>>(first), entry);
+                // moved when passed as rvalue, the parser hands its temporary vector over this way
+                std::vector<ini_tuple_element> first = std::get<0>(std::forward_as_tuple(std::forward<Types>(types)...));
+                if(std::get<1>(std::forward_as_tuple(types...))) entry.emplace<std::vector<ini_tuple_element>>(std::move(first));
+                else check_and_convert_vector(std::move(first), entry);
             }
             else if constexpr (is_vector_ini_type_v<Types...>) //clang nonsense
             {
@@ -123,6 +286,32 @@ namespace dot
 
         [[nodiscard]] constexpr size_t index() const noexcept { return entry.index(); }
 
+        [[nodiscard]] const raw* get_raw() const noexcept { return std::get_if<raw>(&entry); }
+
+        template<typename T>
+        [[nodiscard]] const T* get_if() const noexcept { return std::get_if<T>(&entry); }
+
+        template<typename T>
+        [[nodiscard]] T* get_if() noexcept { return std::get_if<T>(&entry); }
+
+        template<typename T, typename... Args>
+        T& emplace(Args&&... args) { return entry.emplace<T>(std::forward<Args>(args)...); }
+
+        template<typename F>
+        decltype(auto) visit(F&& fn) const { return std::visit(std::forward<F>(fn), entry); }
+
+        // the stored list without a copy, T is the element type it is stored as: double, long, std::string or ini_tuple_element
+        template<typename T>
+        [[nodiscard]] array_view<T> view() const
+        {
+            static_assert(not std::is_same_v<T, bool>, "a list of bools is not stored contiguously");
+            const auto& vec = std::get<std::vector<T>>(entry);
+            return array_view<T>(vec.data(), vec.size());
+        }
+
+        [[nodiscard]] friend bool operator==(const inivariable& lhs, const inivariable& rhs) { return lhs.entry == rhs.entry; }
+        [[nodiscard]] friend bool operator!=(const inivariable& lhs, const inivariable& rhs) { return not (lhs == rhs); }
+
         template<typename T, std::enable_if_t<is_stored_const_ref_v<T>, int> = 0>
         [[nodiscard]] operator const T&() const noexcept
         {
@@ -139,14 +328,14 @@ namespace dot
         template<typename T, std::enable_if_t<is_stored_type_v<T> or std::is_same_v<T, ini_tuple_element>, int> = 0>
         [[nodiscard]] operator const std::vector<T>&() const noexcept
         {
-            return std::get<std::vector<T>>(entry);
+            return get_vector<T>(entry);
         }
 
         template<typename T>
         [[nodiscard]] operator std::vector<T>() const noexcept
         {
             static_assert(is_convertible_type_v<T>, "please only use types convertible to: double, long or std::string");
-            const auto& vec = std::get<std::vector<type_converter_t<T>>>(entry);
+            const auto& vec = get_vector<type_converter_t<T>>(entry);
             return std::vector<T>(vec.begin(), vec.end());
         }
 
@@ -174,8 +363,22 @@ namespace dot
         template<typename T>
         static void fill_vector(std::vector<ini_tuple_element>&& vec, ini_element& entry)
         {
-            auto& type_vec = entry.emplace<std::vector<T>>(vec.size());
-            for(size_t i = 0; i < vec.size(); i++) type_vec[i] = std::get<T>(vec[i]);
+            auto& type_vec = emplace_vector<T>(entry, vec.size());
+            for(size_t i = 0; i < vec.size(); i++) type_vec[i] = std::move(std::get<T>(vec[i]));
+        }
+
+        template<typename T>
+        [[nodiscard]] static const std::vector<T>& get_vector(const ini_element& entry)
+        {
+            if constexpr(std::is_same_v<T, bool>) return std::get<boxed<std::vector<bool>>>(entry).get();
+            else return std::get<std::vector<T>>(entry);
+        }
+
+        template<typename T>
+        static std::vector<T>& emplace_vector(ini_element& entry, size_t size)
+        {
+            if constexpr(std::is_same_v<T, bool>) return entry.emplace<boxed<std::vector<bool>>>(std::vector<bool>(size)).get();
+            else return entry.emplace<std::vector<T>>(size);
         }
 
         template<size_t I = 0>
@@ -193,9 +396,9 @@ namespace dot
         static void fill_vector(std::vector<ini_tuple_element>& vec, Types&&... types) noexcept
         {
             using Type = std::decay_t<std::tuple_element_t<I, typename std::tuple<Types...>>>;
-            auto&& elem = std::get<I>(std::tuple(types...));
+            auto&& elem = std::get<I>(std::forward_as_tuple(types...));
 
-            if constexpr(is_convertible_type_v<Type>()) vec[I] = static_cast<type_converter_t<Type>>(elem);
+            if constexpr(is_convertible_type_v<Type>) vec[I] = static_cast<type_converter_t<Type>>(elem);
             else static_assert(false_type<Type>::value, "type for tuple not supported");
 
             if constexpr (I+1 == sizeof...(Types)) return;
@@ -207,7 +410,7 @@ namespace dot
         {
             using Type = std::decay_t<std::tuple_element_t<I, typename std::tuple<Types...>>>;
 
-            if constexpr(is_convertible_type_v<Type>()) std::get<I>(tuple) = std::get<type_converter_t<Type>>(vec[I]);
+            if constexpr(is_convertible_type_v<Type>) std::get<I>(tuple) = static_cast<Type>(std::get<type_converter_t<Type>>(vec[I]));
             else static_assert(false_type<Type>::value, "type for tuple not supported");
 
             if constexpr (I+1 == sizeof...(Types)) return;
@@ -218,6 +421,36 @@ namespace dot
     };
 
 
+    // the alternative of an inivariable that values of type T are kept in, and its index
+    template<typename T> struct stored_type { using type = type_converter_t<T>; };
+    template<typename T> struct stored_type<std::vector<T>> { using type = std::conditional_t<std::is_same_v<T, bool>, boxed<std::vector<bool>>, std::vector<T>>; };
+
+    template<typename T>
+    using stored_type_t = typename stored_type<T>::type;
+
+    // whether T is one of the types an inivariable stores as is
+    template<typename T, typename Variant = inivariable::ini_element>
+    struct is_alternative;
+    template<typename T, typename... Types>
+    struct is_alternative<T, std::variant<Types...>> : std::disjunction<std::is_same<T, Types>...> {};
+    template<typename T>
+    constexpr inline bool is_alternative_v = is_alternative<T>::value;
+
+    template<typename T, size_t I = 0>
+    constexpr size_t stored_index()
+    {
+        if constexpr(I == std::variant_size_v<inivariable::ini_element>)
+        {
+            static_assert(false_type<T>::value, "type must be bool, a number, std::string or a vector of bool, double, long or std::string");
+            return I;
+        }
+        else if constexpr(std::is_same_v<std::variant_alternative_t<I, inivariable::ini_element>, stored_type_t<T>>) return I;
+        else return stored_index<T, I + 1>();
+    }
+
+    template<typename T>
+    class handle;
+
     class entry
     {
     public:
@@ -226,51 +459,122 @@ namespace dot
         template<typename... Types>
         explicit entry(Types&&... types) : variable(std::forward<Types>(types)...) {}
 
-        [[nodiscard]] constexpr size_t index() const noexcept
+        // a copy may outlive the settings whose file a lazy value points into, so it is decoded first
+        entry(const entry& other) : variable((other.decode(), std::as_const(other.variable))), side(other.copy_side().release()) {}
+        entry(entry&& other) noexcept : variable(std::move(other.variable)), side(other.side.exchange(nullptr)), changed(other.changed) {}
+
+        // assigning a whole entry is a write, it is saved like one and the conversions of the old value are dropped
+        entry& operator=(const entry& other)
         {
+            other.decode();
+            variable = other.variable;
+            delete side.exchange(other.copy_side().release());
+            changed = true;
+            return *this;
+        }
+        entry& operator=(entry&& other) noexcept
+        {
+            take(std::move(other));
+            changed = true;
+            invalidate();
+            return *this;
+        }
+
+        ~entry()
+        {
+            delete side.load();
+        }
+
+        [[nodiscard]] size_t index() const
+        {
+            decode();
             return variable.index();
         }
 
+        // a lazy value is never empty, so this does not need to decode it
         [[nodiscard]] bool empty() const noexcept
         {
-            return index() == 0;
+            return variable.index() == 0;
         }
         [[nodiscard]] bool has_value() const noexcept
         {
             return not empty();
         }
-        [[nodiscard]] bool is_variable() const noexcept
+        // these decode a lazy value, so they throw its syntax error like index does
+        [[nodiscard]] bool is_variable() const
         {
             return index() > 0 and index() < 5;
         }
-        [[nodiscard]] bool is_vector() const noexcept
+        [[nodiscard]] bool is_vector() const
         {
             return index() > 4 and index() < 9;
         }
-        [[nodiscard]] bool is_tuple() const noexcept
+        [[nodiscard]] bool is_tuple() const
         {
             return index() == 9;
         }
 
-        void attach_callback(std::function<void(const entry&, void*)> fn, void* args = nullptr) const noexcept
+        void attach_callback(std::function<void(const entry&, void*)> fn, void* args = nullptr) const
         {
-            callback = std::move(fn);
-            callback_data = args;
+            auto& block = side_data();
+            block.fn = std::move(fn);
+            block.data = args;
         }
 
         [[nodiscard]] const inivariable& value() const
         {
             if(empty()) throw std::runtime_error("accessing empty variable");
+            decode();
             return variable;
         }
 
         template<typename... Types>
         [[nodiscard]] inivariable value_or(Types&&... types) const
         {
-            if(empty()) return IniVariable(std::forward<Types>(types)...);
+            if(empty()) return inivariable(std::forward<Types>(types)...);
+            decode();
             return variable;
         }
 
+        // the value converted to T, kept with the entry until it is written, erased or reloaded, so converting again is free.
+        // a T the value is stored as, like std::vector<double> or std::string, is returned without a copy or a cache.
+        // conversions are published atomically, so readers of a shared snapshot, like the one of a concurrent_settings,
+        // can convert the same entry at the same time. a value that is still lazy is not safe to convert like that.
+        template<typename T>
+        [[nodiscard]] const T& as() const
+        {
+            const auto& current = value();
+            if constexpr(is_alternative_v<T>)
+            {
+                if(const auto stored = current.get_if<T>()) return *stored;
+                throw std::bad_variant_access();
+            }
+            else
+            {
+                auto& block = side_data();
+                const auto find = [](const conversion* node, const conversion* last) -> const T*
+                {
+                    for(; node != last; node = node->next)
+                    {
+                        if(node->type == typeid(T)) return static_cast<const T*>(node->value.get());
+                    }
+                    return nullptr;
+                };
+
+                auto checked = block.conversions.load(std::memory_order_acquire);
+                if(const auto found = find(checked, nullptr)) return *found;
+
+                // another reader may add conversions in the meantime, only those are searched again before trying once more
+                auto converted = std::make_unique<conversion>(conversion{typeid(T), std::make_shared<const T>(static_cast<T>(current)), checked});
+                while(not block.conversions.compare_exchange_weak(converted->next, converted.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    if(const auto found = find(converted->next, checked)) return *found;
+                    checked = converted->next;
+                }
+                return *static_cast<const T*>(converted.release()->value.get());
+            }
+        }
+
         template<typename... Types>
         void write(Types&&... types)
         {
@@ -289,40 +593,313 @@ namespace dot
         void write_or_change(Types&&... types) noexcept
         {
             variable = inivariable(std::forward<Types>(types)...);
-            if(callback != nullptr) callback(*this, callback_data);
+            changed = true;
+            invalidate();
+            notify();
         }
 
         void erase() noexcept
         {
             variable = inivariable();
+            changed = true;
+            invalidate();
+        }
+
+        // written or erased since it was loaded or last saved
+        [[nodiscard]] bool dirty() const noexcept
+        {
+            return changed;
+        }
+
+        // the text of a lazy value that was not accessed yet, empty otherwise
+        [[nodiscard]] std::string_view undecoded() const noexcept
+        {
+            const auto text = variable.get_raw();
+            return (text == nullptr) ? std::string_view() : std::string_view(text->data, text->size);
+        }
+
+    private:
+        friend class settings;
+        template<typename T> friend class handle;
+        template<typename Struct, typename... Members> friend class schema;
+
+        struct conversion
+        {
+            std::type_index type;
+            std::shared_ptr<const void> value;
+            const conversion* next;
+        };
+
+        struct side_block
+        {
+            explicit side_block(std::function<void(const entry&, void*)> callback = nullptr, void* args = nullptr) : fn(std::move(callback)), data(args) {}
+            side_block(const side_block&) = delete;
+            side_block& operator=(const side_block&) = delete;
+            ~side_block() { clear(); }
+
+            void clear() noexcept
+            {
+                for(auto node = conversions.exchange(nullptr); node != nullptr;)
+                {
+                    const auto next = node->next;
+                    delete node;
+                    node = next;
+                }
+            }
+
+            std::function<void(const entry&, void*)> fn;
+            void* data = nullptr;
+            // conversions made by as, a type is looked up linearly as an entry is read as very few types.
+            // a conversion is only ever pushed to the front, so a reader never sees one move or go away.
+            std::atomic<const conversion*> conversions = nullptr;
+        };
+
+        // moves a loaded entry in without marking it, for the parser, merge and reload
+        void take(entry&& other) noexcept
+        {
+            variable = std::move(other.variable);
+            delete side.exchange(other.side.exchange(nullptr));
+            changed = other.changed;
+        }
+
+        // made by the first reader that needs it, a reader that loses the race to publish it frees its own
+        side_block& side_data() const
+        {
+            auto current = side.load(std::memory_order_acquire);
+            if(current != nullptr) return *current;
+
+            auto created = std::make_unique<side_block>();
+            if(side.compare_exchange_strong(current, created.get(), std::memory_order_acq_rel, std::memory_order_acquire)) return *created.release();
+            return *current;
+        }
+
+        void notify() const
+        {
+            const auto block = side.load(std::memory_order_acquire);
+            if(block != nullptr and block->fn != nullptr) block->fn(*this, block->data);
+        }
+
+        // only called by the owner of the entry, never while others read it
+        void invalidate() const noexcept
+        {
+            if(const auto block = side.load(std::memory_order_acquire)) block->clear();
+        }
+
+        // the callback goes with a copy, the conversions are made again when they are needed
+        [[nodiscard]] std::unique_ptr<side_block> copy_side() const
+        {
+            const auto block = side.load(std::memory_order_acquire);
+            return (block == nullptr) ? nullptr : std::make_unique<side_block>(block->fn, block->data);
+        }
+
+        void decode() const
+        {
+            if(const auto text = variable.get_raw()) decode(*text);
+        }
+        void decode(const inivariable::raw& text) const;
+
+        // decoding a lazy value on first access changes it behind a const reference,
+        // so concurrent readers of a lazily loaded settings need their own synchronisation
+        mutable inivariable variable;
+
+        // most entries never get a callback or are read through as, so those live in their own allocation that is only made when needed.
+        // it is owned by the entry and atomic so readers can create it concurrently.
+        mutable std::atomic<side_block*> side = nullptr;
+
+        bool changed = false;
+    };
+
+    [[nodiscard]] constexpr size_t hash(std::string_view string) noexcept
+    {
+        // 64 bit fnv-1a, constexpr so literal keys can be hashed at compile time
+        size_t result = 14695981039346656037ull;
+        for(const char c : string)
+        {
+            result ^= static_cast<unsigned char>(c);
+            result *= 1099511628211ull;
+        }
+        return result;
+    }
+
+    // a section or variable name with its hash, constexpr so constant keys are hashed once at compile time:
+    // static constexpr dot::key var0 = "var0";
+    struct key
+    {
+        constexpr key(const char* string) noexcept : key(std::string_view(string)) {}
+        constexpr key(std::string_view string) noexcept : name(string), hash(dot::hash(string)) {}
+        // a name whose hash is known already, it has to be dot::hash(string)
+        constexpr key(std::string_view string, size_t string_hash) noexcept : name(string), hash(string_hash) {}
+        template<typename Allocator>
+        key(const std::basic_string<char, std::char_traits<char>, Allocator>& string) noexcept : key(std::string_view(string)) {}
+
+        std::string_view name;
+        size_t hash;
+    };
+
+    // open addressing index over an insertion ordered list, iteration order is the order of insertion.
+    // elements live in a deque so references stay valid when new keys are added.
+    // everything, keys included, is allocated from one memory resource which is passed on to allocator aware values.
+    template<typename Value>
+    class ordered_map
+    {
+    public:
+        using value_type = std::pair<std::pmr::string, Value>;
+        using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+        ordered_map() = default;
+        explicit ordered_map(const allocator_type& allocator) : items(allocator), slots(allocator) {}
+
+        ordered_map(const ordered_map& other) = default;
+        ordered_map(const ordered_map& other, const allocator_type& allocator) : items(other.items, allocator), slots(other.slots, allocator) {}
+
+        ordered_map(ordered_map&& other) noexcept = default;
+        ordered_map(ordered_map&& other, const allocator_type& allocator) : items(std::move(other.items), allocator), slots(std::move(other.slots), allocator) {}
+
+        ordered_map& operator=(const ordered_map& other) = default;
+        ordered_map& operator=(ordered_map&& other) = default;
+
+        [[nodiscard]] Value* find(std::string_view key, size_t key_hash) noexcept
+        {
+            const auto index = find_index(key, key_hash);
+            return (index == npos) ? nullptr : &items[index].second;
+        }
+
+        [[nodiscard]] const Value* find(std::string_view key, size_t key_hash) const noexcept
+        {
+            const auto index = find_index(key, key_hash);
+            return (index == npos) ? nullptr : &items[index].second;
+        }
+
+        [[nodiscard]] Value* find(std::string_view key) noexcept { return find(key, hash(key)); }
+        [[nodiscard]] const Value* find(std::string_view key) const noexcept { return find(key, hash(key)); }
+
+        std::pair<Value*, bool> try_emplace(std::string_view key, size_t key_hash)
+        {
+            if(const auto index = find_index(key, key_hash); index != npos) return {&items[index].second, false};
+            if(items.size() >= max_size) throw std::length_error("too many keys");
+            if(2 * (items.size() + 1) > slots.size()) grow();
+
+            insert_slot(key_hash, items.size());
+            return {&items.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple()).second, true};
+        }
+
+        std::pair<Value*, bool> try_emplace(std::string_view key) { return try_emplace(key, hash(key)); }
+
+        [[nodiscard]] auto begin() const noexcept { return items.begin(); }
+        [[nodiscard]] auto end() const noexcept { return items.end(); }
+
+        [[nodiscard]] auto begin() noexcept { return items.begin(); }
+        [[nodiscard]] auto end() noexcept { return items.end(); }
+
+        [[nodiscard]] auto empty() const noexcept { return items.empty(); }
+        [[nodiscard]] auto size() const noexcept { return items.size(); }
+
+        void clear() noexcept
+        {
+            items.clear();
+            slots.clear();
+        }
+
+        // sizes the index for count keys at once, instead of growing it step by step while they are added
+        void reserve(size_t count)
+        {
+            auto size = slots.empty() ? size_t(16) : slots.size();
+            while(size < 2 * count) size *= 2;
+            if(size > slots.size()) rehash(size);
         }
 
     private:
-        inivariable variable;
+        // the low half of the hash picks the slot and filters out most string compares, 8 bytes per slot
+        struct slot
+        {
+            uint32_t hash = 0;
+            uint32_t index = empty_slot;
+        };
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+        static constexpr uint32_t empty_slot = static_cast<uint32_t>(-1);
+        static constexpr size_t max_size = empty_slot;
+
+        [[nodiscard]] size_t find_index(std::string_view key, size_t key_hash) const noexcept
+        {
+            if(slots.empty()) return npos;
+
+            const auto hash = static_cast<uint32_t>(key_hash);
+            const auto mask = slots.size() - 1;
+            for(auto i = hash & mask; slots[i].index != empty_slot; i = (i + 1) & mask)
+            {
+                if(slots[i].hash == hash and items[slots[i].index].first == key) return slots[i].index;
+            }
+            return npos;
+        }
+
+        void insert_slot(size_t key_hash, size_t index) noexcept
+        {
+            const auto hash = static_cast<uint32_t>(key_hash);
+            const auto mask = slots.size() - 1;
+            auto i = hash & mask;
+            while(slots[i].index != empty_slot) i = (i + 1) & mask;
+            slots[i] = slot{hash, static_cast<uint32_t>(index)};
+        }
+
+        void grow()
+        {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+
+        void rehash(size_t size)
+        {
+            auto old = std::move(slots);
+            slots = std::pmr::vector<slot>(size, old.get_allocator());
+            for(const auto& elem : old)
+            {
+                if(elem.index != empty_slot) insert_slot(elem.hash, elem.index);
+            }
+        }
 
-        mutable std::function<void(const entry&, void*)> callback = nullptr;
-        mutable void* callback_data = nullptr;
+        std::pmr::deque<value_type> items;
+        std::pmr::vector<slot> slots;
     };
 
     class section
     {
     public:
+        using allocator_type = ordered_map<entry>::allocator_type;
+
         section() = default;
+        explicit section(const allocator_type& allocator) : map(allocator) {}
+
+        section(const section& other) = default;
+        section(const section& other, const allocator_type& allocator) : map(other.map, allocator) {}
+
+        section(section&& other) noexcept = default;
+        section(section&& other, const allocator_type& allocator) : map(std::move(other.map), allocator) {}
 
-        entry& operator[](const std::string& key) noexcept
+        section& operator=(const section& other) = default;
+        section& operator=(section&& other) = default;
+
+        entry& operator[](dot::key key)
         {
-            const auto iter = std::find_if(map.begin(), map.end(), [&key](const auto& elem){ return elem.first == key; });
-            if(iter == map.end()) return map.emplace_back(key, entry()).second;
-            else return iter->second;
+            const auto [result, inserted] = map.try_emplace(key.name, key.hash);
+            stats::lookup(not inserted);
+            return *result;
         }
 
-        const entry& operator[](const std::string& key) const noexcept
+        const entry& operator[](dot::key key) const noexcept
         {
-            const auto iter = std::find_if(map.begin(), map.end(), [&key](const auto& elem){ return elem.first == key; });
-            if(iter == map.end()) return item;
-            else return iter->second;
+            const auto result = map.find(key.name, key.hash);
+            stats::lookup(result != nullptr);
+            if(result == nullptr) return item;
+            else return *result;
         }
 
+        [[nodiscard]] entry* find(dot::key key) noexcept { return map.find(key.name, key.hash); }
+        [[nodiscard]] const entry* find(dot::key key) const noexcept { return map.find(key.name, key.hash); }
+
+        [[nodiscard]] bool contains(dot::key key) const noexcept { return find(key) != nullptr; }
+
+        void reserve(size_t count) { map.reserve(count); }
+
         [[nodiscard]] auto begin() const noexcept { return map.begin(); }
         [[nodiscard]] auto end() const noexcept { return map.end(); }
 
@@ -333,16 +910,98 @@ namespace dot
         [[nodiscard]] auto size() const noexcept { return map.size(); }
 
     private:
-        std::vector<std::pair<std::string, entry>> map;
+        friend class settings;
+
+        // operator[] without counting, for the parser and the other internal users
+        entry& emplace(dot::key key)
+        {
+            return *map.try_emplace(key.name, key.hash).first;
+        }
+
+        ordered_map<entry> map;
         inline static const entry item = entry();
     };
 
+    // an entry resolved once, reading it is a check of the stored type and a load, without hashing, lookup or variant dispatch.
+    // it stays valid across write, change and erase, as entries never move while their section exists.
+    // resolve it from a non const section, so a missing entry is created and picked up once it is written.
+    template<typename T>
+    class handle
+    {
+        using stored = stored_type_t<T>;
+        static constexpr size_t alternative() { return stored_index<T>(); }
+
+    public:
+        explicit handle(const entry& resolved) noexcept : target(&resolved) {}
+
+        [[nodiscard]] decltype(auto) get() const
+        {
+            if(target->variable.index() != alternative() or cached == nullptr) resolve();
+
+            if      constexpr(std::is_same_v<stored, boxed<std::vector<bool>>>) return static_cast<const std::vector<bool>&>(cached->get());
+            else if constexpr(std::is_same_v<stored, std::string> or std::is_same_v<stored, T>) return static_cast<const stored&>(*cached);
+            else return static_cast<T>(*cached);
+        }
+
+        [[nodiscard]] decltype(auto) operator*() const { return get(); }
+
+    private:
+        void resolve() const
+        {
+            if(target->empty()) throw std::runtime_error("accessing empty variable");
+            if(target->index() != alternative()) throw std::runtime_error("handle does not match the type of the variable");
+
+            // the address of the value inside the variant, the same for as long as it holds this type
+            cached = target->variable.template get_if<stored>();
+        }
+
+        const entry* target;
+        mutable const stored* cached = nullptr;
+    };
+
+    // growable output for the printer that formats numbers with std::to_chars instead of going through iostreams
+    class inibuffer
+    {
+    public:
+        inibuffer& operator<<(char c)
+        {
+            data.push_back(c);
+            return *this;
+        }
+        inibuffer& operator<<(std::string_view text)
+        {
+            data.append(text);
+            return *this;
+        }
+        inibuffer& operator<<(long value);
+        inibuffer& operator<<(double value);
+
+        [[nodiscard]] std::string_view view() const noexcept { return data; }
+        [[nodiscard]] size_t size() const noexcept { return data.size(); }
+
+        // drops everything after the first size characters
+        void truncate(size_t size) { data.resize(size); }
+
+        [[nodiscard]] std::string release() noexcept { return std::move(data); }
+
+    private:
+        std::string data;
+    };
+
     struct iniprinter
     {
+        // the shortest text that reads back as the same double, always with a '.' or an exponent so it is not read back as a long
+        [[nodiscard]] static std::string_view format(double value, char (&buffer)[32]) noexcept;
+
         template<typename T, typename V>
         static T& print(T& stream, const V& val)
         {
             if      constexpr (std::is_same_v<V, bool>) stream << (val?"true":"false");
+            else if constexpr (std::is_same_v<V, double>)
+            {
+                char buffer[32];
+                stream << format(val, buffer);
+            }
             else if constexpr (std::is_same_v<V, std::string>) stream << '"' << val << '"';
             else if constexpr (std::is_same_v<V, dot::inivariable::ini_tuple_element>)
             {
@@ -370,6 +1029,13 @@ namespace dot
         template<typename T>
         static T& print(T& stream, const entry& entry)
         {
+            // a value that was never accessed is written back as it was read
+            if(const auto text = entry.undecoded(); not text.empty())
+            {
+                stream << text;
+                return stream;
+            }
+
             switch(entry.index())
             {
                 case 0: return stream;
@@ -397,8 +1063,11 @@ namespace dot
 //            }
 //        }
 
+        // writes the header first and takes it back when no variable follows, instead of checking the section up front
+        static inibuffer& print(inibuffer& buffer, std::string_view name, const section& section);
+
         template<typename T>
-        static T& print(T& stream, const std::string& name, const section& section)
+        static T& print(T& stream, std::string_view name, const section& section)
         {
             if( std::none_of(section.begin(), section.end(), [](const auto& data){ return data.second.has_value(); }) ) return stream;
             stream << '[' << name << "]\n";
@@ -414,15 +1083,71 @@ namespace dot
         }
     };
 
+    // writes and erases that settings::commit applies together, in the order they were staged
+    class batch
+    {
+    public:
+        template<typename... Types>
+        batch& write_or_change(dot::key section, dot::key key, Types&&... types)
+        {
+            writes.push_back(staged{std::string(section.name), section.hash, std::string(key.name), key.hash, inivariable(std::forward<Types>(types)...)});
+            return *this;
+        }
+
+        batch& erase(dot::key section, dot::key key)
+        {
+            writes.push_back(staged{std::string(section.name), section.hash, std::string(key.name), key.hash, inivariable()});
+            return *this;
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return writes.empty(); }
+        [[nodiscard]] size_t size() const noexcept { return writes.size(); }
+
+    private:
+        friend class settings;
+
+        struct staged
+        {
+            std::string section;
+            size_t section_hash;
+            std::string key;
+            size_t key_hash;
+            // empty for an erase
+            inivariable value;
+        };
+
+        std::vector<staged> writes;
+    };
+
+    // an entry that was changed by a commit or a reload, the names are only valid during the call to the listener
+    struct change
+    {
+        std::string_view section;
+        std::string_view key;
+        const entry* value;
+    };
+
     class settings
     {
     public:
         settings() = default;
 
-        explicit settings(std::string file_path);
+        explicit settings(std::string file_path, load_options options = {});
+
+        // a moved from settings no longer writes to its file
+        settings(settings&& other) noexcept;
+        settings& operator=(settings&& other);
 
         ~settings();
 
+        // parses the files in parallel and merges them in order, a key in a later file overrides the same key in earlier ones.
+        // threads = 0 uses one thread per core. mmap, lazy, cache and the threads of options are used for every file, arena by the result.
+        // the result is not tied to any file and is never saved, it only keeps async, debounce and on_error.
+        [[nodiscard]] static settings load_many(const std::vector<std::string>& paths, unsigned threads = 0, load_options options = {});
+
+        // load_many on every .ini file in the directory, sorted by name
+        [[nodiscard]] static settings load_directory(const std::string& directory, unsigned threads = 0, load_options options = {});
+
         [[nodiscard]] auto begin() const noexcept { return map.begin(); }
         [[nodiscard]] auto end() const noexcept { return map.end(); }
 
@@ -443,31 +1168,125 @@ namespace dot
             return stream;
         }
 
-        section& operator[](const std::string& key) noexcept
+        section& operator[](dot::key key)
         {
-            const auto iter = std::find_if(map.begin(), map.end(), [&key](const auto& elem){ return elem.first == key; });
-            if(iter == map.end()) return map.emplace_back(key, section()).second;
-            else return iter->second;
+            const auto [result, inserted] = map.try_emplace(key.name, key.hash);
+            stats::lookup(not inserted);
+            return *result;
         }
 
-        const section& operator[](const std::string& key) const
+        const section& operator[](dot::key key) const
         {
-            const auto iter = std::find_if(map.begin(), map.end(), [&key](const auto& elem){ return elem.first == key; });
-            if(iter != map.end()) return iter->second;
-            else throw std::runtime_error("could not find section with key" + std::string(key));
+            const auto result = map.find(key.name, key.hash);
+            stats::lookup(result != nullptr);
+            if(result != nullptr) return *result;
+            else throw std::runtime_error("could not find section with key" + std::string(key.name));
         }
 
+        [[nodiscard]] section* find(dot::key key) noexcept { return map.find(key.name, key.hash); }
+        [[nodiscard]] const section* find(dot::key key) const noexcept { return map.find(key.name, key.hash); }
+
+        [[nodiscard]] bool contains(dot::key key) const noexcept { return find(key) != nullptr; }
+
+        [[nodiscard]] const std::string& file() const noexcept { return path; }
+
+        // every section and value, decoded, in a settings that is not tied to the file
+        [[nodiscard]] settings copy() const;
+
+        // parses the file again and takes over every value that differs from the one in memory, calling the callbacks of those entries.
+        // keys that are gone from the file are erased. entries with unsaved changes keep them, the others stay clean.
+        // returns the number of entries that changed, a file that does not parse throws and changes nothing.
+        size_t reload();
+
+        // applies the writes of the batch, then calls the callback of every entry that changed once and every listener once.
+        // callbacks only run when the whole batch is applied, so they never see it half done.
+        // a write of the value an entry already has is skipped, returns the number of entries that changed.
+        // with load_options::async the changes are saved in the background afterwards.
+        size_t commit(batch&& writes);
+
+        // saves the unsaved changes, the future is ready once they are on disk and holds the error when that failed.
+        // with load_options::async they are copied and written by a background thread after the debounce delay,
+        // otherwise they are written before it returns. a failed write is not tried again, the values stay in memory.
+        std::future<void> flush();
+
+        // called once per commit or reload that changed something, with every entry that changed, after their own callbacks
+        void listen(std::function<void(const std::vector<change>&)> fn);
+
+        // resolves many names in one pass, consecutive names in the same section look up the section once.
+        // the result has an entry for every name, nullptr when it does not exist.
+        [[nodiscard]] std::vector<const entry*> find_all(const std::vector<std::pair<dot::key, dot::key>>& names) const;
+
+        // decodes the raw text of a variable as it was handed to iniparser::handler::on_variable
+        [[nodiscard]] static entry parse_value(std::string_view value, int line);
+
+        // writes every section and value to a versioned and checksummed binary file that load_binary reads without parsing text.
+        // names and strings sit in one table, the index holds their hashes and the values are stored as typed arrays,
+        // so it can be mapped and read in place. it uses the byte order of this machine.
+        void save_binary(const std::string& file) const;
+
+        // the settings in a file written by save_binary, not tied to any file. a truncated or corrupt file throws.
+        [[nodiscard]] static settings load_binary(const std::string& file);
+
     private:
+        void load(const std::string& file, load_options options);
+        // returns the line of every section header, in order. when stopped is given a last line that does not end
+        // in a newline is left alone, as with iniparser::tokenize(partial), and where parsing stopped is stored in it.
+        std::vector<int> parse(iterator begin, iterator end, bool lazy, mapped_file* source = nullptr, int line = 1, iterator* stopped = nullptr);
+        void parse_parallel(iterator begin, iterator end, unsigned threads, bool lazy);
+        void merge(settings&& other);
+        void notify(const std::vector<change>& changes) const;
+
+        // the size, modification time in ns and contents hash of the text a snapshot was made from, all 0 when there was none
+        struct source_stamp
+        {
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            uint64_t hash = 0;
+        };
+
+        // the one background thread that writes the files of async settings, in the order they were asked for
+        class flusher;
+
+        // a copy that is not tied to the file, with the same entries dirty
+        [[nodiscard]] settings snapshot() const;
+        // marks the entries that are dirty in other dirty here as well
+        void take_dirty(const settings& other);
+        void mark_saved() noexcept;
+        static void report(const std::string& file, const error_handler& on_error, std::exception_ptr error);
+
+        // patches the dirty values of the snapshot into the file, durable syncs it to disk. throws when it cannot be written.
+        static void write(const std::string& file, const settings& snapshot, bool durable);
+
+        // empty and not tied to a file, with the arena and the save options of options
+        explicit settings(const load_options& options);
+
+        void load_cached(const std::string& file, load_options options);
+        void write_snapshot(const std::string& file, const source_stamp& source) const;
+        void read_snapshot(const mapped_file& snapshot);
+
+        // writes the file only when an entry is dirty, patching the changed values into its current contents.
+        // with async it is handed to the flusher instead, errors go to on_error.
+        void save();
+        [[nodiscard]] bool dirty() const noexcept;
+        [[nodiscard]] std::string patch(const std::string& original) const;
+
         static std::pair<bool, dot::inivariable::ini_tuple_element> parse_tuple_element(iterator& begin, iterator end, int line, char close);
 
-        static std::pair<iterator, dot::inivariable::ini_tuple_element> parse_variable(iterator begin, iterator end, int line) noexcept;
+        static std::pair<iterator, dot::inivariable::ini_tuple_element> parse_variable(iterator begin, iterator end, int line);
 
-        static void error(const char* first, iterator begin, int line);
-        static void error(const char* first, iterator begin, iterator end, int line);
-        static void error(const char* first, int line);
+        static std::pair<iterator, dot::inivariable::ini_tuple_element> parse_number(iterator begin, iterator end, int line);
 
         std::string path;
-        std::vector<std::pair<std::string, section>> map;
+        // declared before the map, which allocates from it
+        std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+        // the file contents lazy values point into
+        std::vector<std::shared_ptr<const void>> sources;
+        ordered_map<section> map;
+        std::vector<std::function<void(const std::vector<change>&)>> listeners;
+
+        bool async = false;
+        std::chrono::milliseconds debounce{};
+        error_handler on_error;
     };
 
 
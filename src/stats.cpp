@@ -0,0 +1,97 @@
+//============================================================================
+// @name        : stats.cpp
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description :
+//============================================================================
+
+#include "stats.h"
+
+#include <atomic>
+#include <mutex>
+#include <ostream>
+
+namespace
+{
+    // loads add up once, lookups are too frequent for a lock
+    std::mutex mutex;
+    dot::stats total;
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+}
+
+dot::stats& dot::stats::operator+=(const stats& other) noexcept
+{
+    files += other.files;
+    bytes += other.bytes;
+    read_ns += other.read_ns;
+    tokenize_ns += other.tokenize_ns;
+    decode_ns += other.decode_ns;
+    insert_ns += other.insert_ns;
+    sections += other.sections;
+    variables += other.variables;
+    strings += other.strings;
+    vectors += other.vectors;
+    tuples += other.tuples;
+    allocations += other.allocations;
+    hits += other.hits;
+    misses += other.misses;
+    return *this;
+}
+
+double dot::stats::bytes_per_second() const noexcept
+{
+    const auto ns = read_ns + tokenize_ns + decode_ns + insert_ns;
+    return (ns == 0) ? 0.0 : static_cast<double>(bytes) * 1e9 / static_cast<double>(ns);
+}
+
+void dot::stats::dump(std::ostream& stream) const
+{
+    stream << "files " << files << '\n'
+           << "bytes " << bytes << '\n'
+           << "bytes_per_second " << static_cast<uint64_t>(bytes_per_second()) << '\n'
+           << "read_ns " << read_ns << '\n'
+           << "tokenize_ns " << tokenize_ns << '\n'
+           << "decode_ns " << decode_ns << '\n'
+           << "insert_ns " << insert_ns << '\n'
+           << "sections " << sections << '\n'
+           << "variables " << variables << '\n'
+           << "strings " << strings << '\n'
+           << "vectors " << vectors << '\n'
+           << "tuples " << tuples << '\n'
+           << "allocations " << allocations << '\n'
+           << "hits " << hits << '\n'
+           << "misses " << misses << '\n';
+}
+
+dot::stats dot::stats::collected()
+{
+    std::lock_guard lock(mutex);
+    auto result = total;
+    result.hits = ::hits.load(std::memory_order_relaxed);
+    result.misses = ::misses.load(std::memory_order_relaxed);
+    return result;
+}
+
+void dot::stats::reset()
+{
+    std::lock_guard lock(mutex);
+    total = stats();
+    ::hits = 0;
+    ::misses = 0;
+}
+
+#ifdef DOT_STATS
+void dot::stats::record(const stats& counted)
+{
+    std::lock_guard lock(mutex);
+    total += counted;
+}
+
+void dot::stats::lookup(bool hit) noexcept
+{
+    (hit ? ::hits : ::misses).fetch_add(1, std::memory_order_relaxed);
+}
+#endif
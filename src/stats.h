@@ -0,0 +1,93 @@
+//============================================================================
+// @name        : stats.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : counters of where the parser spends its time, only collected when built with DOT_STATS
+//============================================================================
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace dot
+{
+    // Everything the parser did in this process since it started or since the last reset.
+    // Without DOT_STATS (cmake -DDOT_STATS=ON) nothing is counted, every counter stays 0 and the counting compiles to nothing.
+    // Loads add their counters once when they are done, parts of a parallel load each add their own.
+    struct stats
+    {
+        static constexpr bool enabled =
+#ifdef DOT_STATS
+            true;
+#else
+            false;
+#endif
+
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+
+        // reading or mapping the file, the tokenizer itself, decoding values and adding them to the tree.
+        // the phases of a parallel load are summed over its threads.
+        uint64_t read_ns = 0;
+        uint64_t tokenize_ns = 0;
+        uint64_t decode_ns = 0;
+        uint64_t insert_ns = 0;
+
+        // values of lazy loads are counted when they are decoded
+        uint64_t sections = 0;
+        uint64_t variables = 0;
+        uint64_t strings = 0;
+        uint64_t vectors = 0;
+        uint64_t tuples = 0;
+        // heap allocations made for decoded values
+        uint64_t allocations = 0;
+
+        // operator[] on a settings or section that found the name, and that did not
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+
+        stats& operator+=(const stats& other) noexcept;
+
+        // bytes over the time of all phases
+        [[nodiscard]] double bytes_per_second() const noexcept;
+
+        // one "name value" line per counter, easy to scrape
+        void dump(std::ostream& stream) const;
+
+        [[nodiscard]] static stats collected();
+        static void reset();
+
+#ifdef DOT_STATS
+        static void record(const stats& counted);
+        static void lookup(bool hit) noexcept;
+#else
+        static void record(const stats&) noexcept {}
+        static void lookup(bool) noexcept {}
+#endif
+
+        // adds the time until it is destroyed to a counter
+        class timer
+        {
+        public:
+#ifdef DOT_STATS
+            explicit timer(uint64_t& counter) noexcept : total(counter), start(std::chrono::steady_clock::now()) {}
+            ~timer() { total += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()); }
+#else
+            explicit timer(uint64_t&) noexcept {}
+#endif
+            timer(const timer&) = delete;
+            timer& operator=(const timer&) = delete;
+
+#ifdef DOT_STATS
+        private:
+            uint64_t& total;
+            std::chrono::steady_clock::time_point start;
+#endif
+        };
+    };
+}
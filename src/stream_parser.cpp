@@ -0,0 +1,50 @@
+//============================================================================
+// @name        : stream_parser.cpp
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description :
+//============================================================================
+
+#include "stream_parser.h"
+
+dot::stream_parser::stream_parser(section_callback on_section, variable_callback on_variable)
+    : section_fn(std::move(on_section)), variable_fn(std::move(on_variable)) {}
+
+void dot::stream_parser::feed(std::string_view chunk)
+{
+    buffer.append(chunk);
+
+    // nothing can be complete without a new line
+    if(chunk.find('\n') != std::string_view::npos) parse(true);
+}
+
+void dot::stream_parser::finish()
+{
+    parse(false);
+}
+
+void dot::stream_parser::parse(bool partial)
+{
+    const auto begin = buffer.data();
+    const auto [current, line] = iniparser::tokenize(begin, begin + buffer.size(), *this, current_line, partial);
+
+    buffer.erase(0, static_cast<size_t>(current - begin));
+    current_line = line;
+}
+
+void dot::stream_parser::on_section(std::string_view name, int)
+{
+    current_section = name;
+    has_section = true;
+    if(section_fn != nullptr) section_fn(current_section);
+}
+
+void dot::stream_parser::on_variable(std::string_view key, std::string_view value, int line)
+{
+    if(not has_section) iniparser::error("variable has no section", line);
+
+    const auto result = settings::parse_value(value, line);
+    if(variable_fn != nullptr) variable_fn(current_section, key, result);
+}
@@ -0,0 +1,49 @@
+//============================================================================
+// @name        : stream_parser.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : push parser for ini data that arrives in pieces
+//============================================================================
+
+
+#pragma once
+
+#include "settings.h"
+
+namespace dot
+{
+    // Feed it chunks of any size, every section and variable is reported as soon as its line is complete.
+    // Only the unfinished last line is kept around, so memory is bounded by the longest line and not by the input.
+    class stream_parser : private iniparser::handler
+    {
+    public:
+        using section_callback = std::function<void(std::string_view name)>;
+        using variable_callback = std::function<void(std::string_view section, std::string_view key, const entry& value)>;
+
+        stream_parser(section_callback on_section, variable_callback on_variable);
+
+        void feed(std::string_view chunk);
+
+        // handles a last line without newline, call it once the input has ended
+        void finish();
+
+        [[nodiscard]] size_t buffered() const noexcept { return buffer.size(); }
+        [[nodiscard]] int line() const noexcept { return current_line; }
+
+    private:
+        void on_section(std::string_view name, int line) override;
+        void on_variable(std::string_view key, std::string_view value, int line) override;
+
+        void parse(bool partial);
+
+        section_callback section_fn;
+        variable_callback variable_fn;
+
+        std::string buffer;
+        std::string current_section;
+        bool has_section = false;
+        int current_line = 1;
+    };
+}
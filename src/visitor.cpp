@@ -0,0 +1,57 @@
+//============================================================================
+// @name        : visitor.cpp
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description :
+//============================================================================
+
+#include "visitor.h"
+
+namespace
+{
+    struct adapter final : dot::iniparser::handler
+    {
+        explicit adapter(dot::visitor& target) : visitor(target) {}
+
+        void on_section(std::string_view name, int line) override
+        {
+            in_section = true;
+            visitor.on_section(name, line);
+            stop = visitor.done();
+        }
+
+        void on_variable(std::string_view key, std::string_view value, int line) override
+        {
+            if(not in_section) dot::iniparser::error("variable has no section", line);
+            if(visitor.on_key(key, line) and not visitor.done()) visitor.on_value(key, value, line);
+            stop = visitor.done();
+        }
+
+        dot::visitor& visitor;
+        bool in_section = false;
+    };
+}
+
+void dot::visitor::on_section(std::string_view, int) {}
+
+bool dot::visitor::on_key(std::string_view, int)
+{
+    return true;
+}
+
+void dot::visitor::on_value(std::string_view, std::string_view, int) {}
+
+void dot::visit(std::string_view data, visitor& visitor)
+{
+    if(visitor.done()) return;
+    adapter handler(visitor);
+    iniparser::tokenize(data.data(), data.data() + data.size(), handler);
+}
+
+void dot::visit_file(const std::string& path, visitor& visitor)
+{
+    const mapped_file file(path);
+    visit(std::string_view(file.begin(), file.size()), visitor);
+}
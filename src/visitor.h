@@ -0,0 +1,48 @@
+//============================================================================
+// @name        : visitor.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : walks the sections and keys of an ini file without building a settings
+//============================================================================
+
+
+#pragma once
+
+#include "settings.h"
+
+#include <string_view>
+
+namespace dot
+{
+    // The events of a file for callers that only read it, to validate it, look for a key or count entries.
+    // It is driven by the tokenizer of settings, so it sees the same lines and throws the same syntax errors for them,
+    // including a variable before the first section, but no sections, entries or values are built and nothing is allocated.
+    // A section name that is used twice is not reported, as that would need every name kept.
+    // Every view points into the visited text, values are the raw text, settings::parse_value decodes one.
+    class visitor
+    {
+    public:
+        virtual ~visitor() = default;
+
+        virtual void on_section(std::string_view name, int line);
+
+        // returning false skips on_value for this key
+        virtual bool on_key(std::string_view key, int line);
+
+        virtual void on_value(std::string_view key, std::string_view value, int line);
+
+        // ends the visit after the current event
+        void stop() noexcept { stopped = true; }
+        [[nodiscard]] bool done() const noexcept { return stopped; }
+
+    private:
+        bool stopped = false;
+    };
+
+    void visit(std::string_view data, visitor& visitor);
+
+    // reads the file from a read only mapping, so it is not copied either
+    void visit_file(const std::string& path, visitor& visitor);
+}
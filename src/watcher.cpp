@@ -0,0 +1,63 @@
+//============================================================================
+// @name        : watcher.cpp
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description :
+//============================================================================
+
+#include "watcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+dot::watcher::watcher(settings& settings) : target(settings)
+{
+    if(target.file().empty()) throw std::runtime_error("settings without a file cannot be watched");
+
+    const auto path = std::filesystem::absolute(target.file());
+    name = path.filename().string();
+
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify < 0) throw std::runtime_error(std::string("could not start watching: ") + std::strerror(errno));
+
+    // a finished write, or a file moved in over the old one
+    if(inotify_add_watch(inotify, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        close(inotify);
+        throw std::runtime_error("could not watch directory of: " + target.file());
+    }
+}
+
+dot::watcher::~watcher()
+{
+    close(inotify);
+}
+
+size_t dot::watcher::poll(std::chrono::milliseconds timeout)
+{
+    pollfd request{inotify, POLLIN, 0};
+    if(::poll(&request, 1, static_cast<int>(timeout.count())) <= 0) return 0;
+
+    bool changed = false;
+    alignas(inotify_event) char buffer[4096];
+    while(true)
+    {
+        const auto length = read(inotify, buffer, sizeof(buffer));
+        if(length <= 0) break;
+
+        for(auto current = buffer; current < buffer + length;)
+        {
+            const auto event = reinterpret_cast<const inotify_event*>(current);
+            if(event->len != 0 and name == event->name) changed = true;
+            current += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed ? target.reload() : 0;
+}
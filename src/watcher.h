@@ -0,0 +1,42 @@
+//============================================================================
+// @name        : watcher.h
+// @author      : Thomas Dooms
+// @date        : 8/20/19
+// @version     : 0.1
+// @copyright   : BA1 Informatica - Thomas Dooms - University of Antwerp
+// @description : reloads a settings when its file is changed on disk
+//============================================================================
+
+
+#pragma once
+
+#include "settings.h"
+
+#include <chrono>
+
+namespace dot
+{
+    // Watches the directory of the file, so editors and tools that replace the file by renaming are seen as well.
+    // Nothing runs in the background: poll reloads on the thread that calls it, which is the one that owns the settings.
+    class watcher
+    {
+    public:
+        explicit watcher(settings& settings);
+        ~watcher();
+
+        watcher(const watcher&) = delete;
+        watcher& operator=(const watcher&) = delete;
+
+        // waits up to timeout for the file to be written or replaced and reloads it once for all the events that came in.
+        // returns the number of entries that changed, a file that does not parse throws and leaves the settings as they were.
+        size_t poll(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+        // readable when there are events, for use in an event loop that calls poll afterwards
+        [[nodiscard]] int descriptor() const noexcept { return inotify; }
+
+    private:
+        settings& target;
+        std::string name;
+        int inotify = -1;
+    };
+}